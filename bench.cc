@@ -0,0 +1,55 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+
+#include "bench.h"
+
+int bench_repetitions = 10;
+
+std::vector<bench_element> const& bench_input(size_t size) {
+  static std::map<size_t, std::vector<bench_element>> cache;
+  auto& input = cache[size];
+  if (input.empty()) {
+    std::mt19937_64 engine(size);
+    std::uniform_int_distribution<int32_t> values(0, 99);
+    input.resize(size);
+    for (size_t i = 0; i < size; ++i)
+      input[i] = bench_element{ double(i), 2. * i, -1. * i, uint16_t(i % 7), values(engine), "element" };
+  }
+  return input;
+}
+
+std::vector<size_t> const& bench_indices(size_t size) {
+  static std::map<size_t, std::vector<size_t>> cache;
+  auto& indices = cache[size];
+  if (indices.empty()) {
+    std::mt19937_64 engine(size + 1);
+    indices.resize(size);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::shuffle(indices.begin(), indices.end(), engine);
+  }
+  return indices;
+}
+
+void bench_report(const char* layout, const char* kernel, size_t size, size_t alignment, double nanoseconds) {
+  std::cout << layout << ',' << kernel << ',' << size << ',' << alignment << ',' << nanoseconds << ',' << nanoseconds / size << std::endl;
+}
+
+// usage: bench [repetitions]
+int main(int argc, char** argv) {
+  if (argc > 1)
+    bench_repetitions = std::max(1, std::atoi(argv[1]));
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "layout,kernel,size,alignment,ns,ns_per_element" << std::endl;
+  bench_v0();
+  bench_v1();
+  bench_v2();
+  bench_v3();
+  bench_v4();
+
+  return 0;
+}
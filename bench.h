@@ -0,0 +1,183 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+/*
+ * Minimal benchmark harness, shared by the bench_v*.cc translation units.
+ *
+ * Each translation unit includes a single version of the SoA headers, to avoid clashes between their macros and type
+ * names, and runs the same set of kernels over its own layouts; the results are printed in CSV format, one line per
+ * (layout, kernel, size, alignment).
+ */
+
+// array of structures element, as in test_v0.cc; used as the input and output of the AoS <-> SoA conversions
+struct bench_element {
+  double x;
+  double y;
+  double z;
+  uint16_t colour;
+  int32_t value;
+  const char* name;
+};
+
+// number of elements and alignment of the SoA columns to sweep over
+constexpr size_t bench_sizes[] = { 1024, 32768, 1048576 };
+constexpr size_t bench_alignments[] = { 0, 64 };
+
+// the filter kernels select the elements with a value above this threshold, roughly half of them
+constexpr int32_t bench_threshold = 50;
+
+// number of times each kernel is repeated; the fastest repetition is reported
+extern int bench_repetitions;
+
+// deterministic input data, with `size` elements
+std::vector<bench_element> const& bench_input(size_t size);
+
+// deterministic random permutation of [0, size), used by the gather kernels
+std::vector<size_t> const& bench_indices(size_t size);
+
+// print the results of one benchmark, in CSV format
+void bench_report(const char* layout, const char* kernel, size_t size, size_t alignment, double nanoseconds);
+
+// prevent the compiler from optimising away the computation of `value`
+template <typename T>
+inline void bench_keep(T const& value) {
+  asm volatile("" : : "r"(&value) : "memory");
+}
+
+// run setup() and kernel() bench_repetitions times, and return the time taken by the fastest kernel(), in nanoseconds
+template <typename SETUP, typename KERNEL>
+double bench_measure(SETUP&& setup, KERNEL&& kernel) {
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < bench_repetitions; ++i) {
+    setup();
+    auto start = std::chrono::steady_clock::now();
+    kernel();
+    auto stop = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::nano>(stop - start).count());
+  }
+  return best;
+}
+
+template <typename KERNEL>
+double bench_measure(KERNEL&& kernel) {
+  return bench_measure([] {}, std::forward<KERNEL>(kernel));
+}
+
+// call RUNNER::run<SIZE, ALIGN>() for all the combinations of bench_sizes and bench_alignments
+template <typename RUNNER, size_t... I>
+void bench_sweep(std::index_sequence<I...>) {
+  constexpr size_t alignments = std::size(bench_alignments);
+  (RUNNER::template run<bench_sizes[I / alignments], bench_alignments[I % alignments]>(), ...);
+}
+
+template <typename RUNNER>
+void bench_sweep() {
+  bench_sweep<RUNNER>(std::make_index_sequence<std::size(bench_sizes) * std::size(bench_alignments)>());
+}
+
+// copy bench_input(size) into a SoA, one element at a time
+template <typename SOA>
+void bench_fill(SOA& soa, size_t size) {
+  auto const& input = bench_input(size);
+  for (size_t i = 0; i < size; ++i) {
+    auto e = soa[i];
+    e.x() = input[i].x;
+    e.y() = input[i].y;
+    e.z() = input[i].z;
+    e.colour() = input[i].colour;
+    e.value() = input[i].value;
+    e.name() = input[i].name;
+  }
+}
+
+// kernels that access a SoA through its column accessors, like soa.x(), and through its element accessors, like
+// soa[i].x(); the initial content of `soa` should be bench_input(size)
+template <typename SOA>
+void bench_columns(const char* layout, SOA& soa, size_t size, size_t alignment) {
+  auto const& indices = bench_indices(size);
+
+  bench_report(layout, "stream", size, alignment, bench_measure([&] {
+    double sum = 0.;
+    auto x = soa.x();
+    for (size_t i = 0; i < size; ++i)
+      sum += x[i];
+    bench_keep(sum);
+  }));
+
+  bench_report(layout, "rows", size, alignment, bench_measure([&] {
+    double sum = 0.;
+    for (size_t i = 0; i < size; ++i) {
+      auto e = soa[i];
+      sum += e.x() + e.y() + e.z() + e.colour() + e.value();
+    }
+    bench_keep(sum);
+  }));
+
+  bench_report(layout, "gather", size, alignment, bench_measure([&] {
+    double sum = 0.;
+    for (size_t i: indices) {
+      auto e = soa[i];
+      sum += e.x() + e.y() + e.z();
+    }
+    bench_keep(sum);
+  }));
+}
+
+// filter, sort and AoS <-> SoA conversion kernels implemented one element at a time, for the SoA types that do not
+// provide bulk operations; the initial content of `soa` should be bench_input(size)
+template <typename SOA>
+void bench_elements(const char* layout, SOA& soa, SOA& other, size_t size, size_t alignment) {
+  std::vector<bench_element> output(size);
+
+  bench_report(layout, "filter", size, alignment, bench_measure([&] {
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i)
+      if (soa[i].value() > bench_threshold)
+        other[count++] = soa[i];
+    bench_keep(count);
+  }));
+
+  // sort the indices by value, then move the elements into `other`
+  std::vector<size_t> permutation(size);
+  bench_report(layout, "sort", size, alignment, bench_measure(
+    [&] { std::iota(permutation.begin(), permutation.end(), 0); },
+    [&] {
+      auto const* value = soa.value();
+      std::stable_sort(permutation.begin(), permutation.end(), [value](size_t a, size_t b) { return value[a] < value[b]; });
+      for (size_t i = 0; i < size; ++i)
+        other[i] = soa[permutation[i]];
+      bench_keep(other);
+    }));
+
+  bench_report(layout, "from_aos", size, alignment, bench_measure([&] {
+    bench_fill(soa, size);
+    bench_keep(soa);
+  }));
+
+  bench_report(layout, "to_aos", size, alignment, bench_measure([&] {
+    for (size_t i = 0; i < size; ++i) {
+      auto e = soa[i];
+      output[i] = bench_element{ e.x(), e.y(), e.z(), e.colour(), e.value(), e.name() };
+    }
+    bench_keep(output);
+  }));
+}
+
+// entry points of the individual translation units
+void bench_v0();
+void bench_v1();
+void bench_v2();
+void bench_v3();
+void bench_v4();
+
+#endif  // BENCH_H
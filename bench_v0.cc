@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "bench.h"
+
+/*
+ * Array of structures, as in test_v0.cc
+ */
+
+namespace {
+
+  using element = bench_element;
+
+  struct runner {
+    template <size_t SIZE, size_t ALIGN>
+    static void run() {
+      // a std::vector does not support over-aligned columns
+      if constexpr (ALIGN == 0) {
+        auto const& input = bench_input(SIZE);
+        auto const& indices = bench_indices(SIZE);
+        std::vector<element> elements(input);
+        std::vector<element> other(SIZE);
+
+        bench_report("v0", "stream", SIZE, ALIGN, bench_measure([&] {
+          double sum = 0.;
+          for (size_t i = 0; i < SIZE; ++i)
+            sum += elements[i].x;
+          bench_keep(sum);
+        }));
+
+        bench_report("v0", "rows", SIZE, ALIGN, bench_measure([&] {
+          double sum = 0.;
+          for (size_t i = 0; i < SIZE; ++i)
+            sum += elements[i].x + elements[i].y + elements[i].z + elements[i].colour + elements[i].value;
+          bench_keep(sum);
+        }));
+
+        bench_report("v0", "gather", SIZE, ALIGN, bench_measure([&] {
+          double sum = 0.;
+          for (size_t i: indices)
+            sum += elements[i].x + elements[i].y + elements[i].z;
+          bench_keep(sum);
+        }));
+
+        bench_report("v0", "filter", SIZE, ALIGN, bench_measure([&] {
+          size_t count = 0;
+          for (size_t i = 0; i < SIZE; ++i)
+            if (elements[i].value > bench_threshold)
+              other[count++] = elements[i];
+          bench_keep(count);
+        }));
+
+        bench_report("v0", "sort", SIZE, ALIGN, bench_measure(
+          [&] { elements = input; },
+          [&] {
+            std::stable_sort(elements.begin(), elements.end(), [](element const& a, element const& b) { return a.value < b.value; });
+            bench_keep(elements);
+          }));
+
+        bench_report("v0", "from_aos", SIZE, ALIGN, bench_measure([&] {
+          std::copy(input.begin(), input.end(), elements.begin());
+          bench_keep(elements);
+        }));
+
+        bench_report("v0", "to_aos", SIZE, ALIGN, bench_measure([&] {
+          std::copy(elements.begin(), elements.end(), other.begin());
+          bench_keep(other);
+        }));
+      }
+    }
+  };
+
+}  // namespace
+
+void bench_v0() {
+  bench_sweep<runner>();
+}
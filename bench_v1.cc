@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "soa_v1.h"
+
+#include "bench.h"
+
+/*
+ * Simple Structure-of-Arrays with a predefined layout, as in test_v1.cc
+ */
+
+namespace {
+
+  struct runner {
+    template <size_t SIZE, size_t ALIGN>
+    static void run() {
+      using SoA = SoATemplate<SIZE, ALIGN>;
+      auto const& input = bench_input(SIZE);
+      auto const& indices = bench_indices(SIZE);
+      std::unique_ptr<SoA> soa(new SoA);
+      std::unique_ptr<SoA> other(new SoA);
+      std::vector<bench_element> output(SIZE);
+
+      auto from_aos = [&] {
+        for (size_t i = 0; i < SIZE; ++i)
+          (*soa)[i] = SoAEntry{ input[i].x, input[i].y, input[i].z, input[i].colour, input[i].value, input[i].name };
+      };
+      from_aos();
+
+      bench_report("v1", "stream", SIZE, ALIGN, bench_measure([&] {
+        double sum = 0.;
+        for (size_t i = 0; i < SIZE; ++i)
+          sum += soa->x[i];
+        bench_keep(sum);
+      }));
+
+      bench_report("v1", "rows", SIZE, ALIGN, bench_measure([&] {
+        double sum = 0.;
+        for (size_t i = 0; i < SIZE; ++i) {
+          auto e = (*soa)[i];
+          sum += e.x + e.y + e.z + e.colour + e.value;
+        }
+        bench_keep(sum);
+      }));
+
+      bench_report("v1", "gather", SIZE, ALIGN, bench_measure([&] {
+        double sum = 0.;
+        for (size_t i: indices) {
+          auto e = (*soa)[i];
+          sum += e.x + e.y + e.z;
+        }
+        bench_keep(sum);
+      }));
+
+      bench_report("v1", "filter", SIZE, ALIGN, bench_measure([&] {
+        size_t count = 0;
+        for (size_t i = 0; i < SIZE; ++i)
+          if (soa->value[i] > bench_threshold)
+            (*other)[count++] = (*soa)[i];
+        bench_keep(count);
+      }));
+
+      // sort the indices by value, then move the elements into `other`
+      std::vector<size_t> permutation(SIZE);
+      bench_report("v1", "sort", SIZE, ALIGN, bench_measure(
+        [&] { std::iota(permutation.begin(), permutation.end(), 0); },
+        [&] {
+          auto const* value = soa->value;
+          std::stable_sort(permutation.begin(), permutation.end(), [value](size_t a, size_t b) { return value[a] < value[b]; });
+          for (size_t i = 0; i < SIZE; ++i)
+            (*other)[i] = (*soa)[permutation[i]];
+          bench_keep(*other);
+        }));
+
+      bench_report("v1", "from_aos", SIZE, ALIGN, bench_measure([&] {
+        from_aos();
+        bench_keep(*soa);
+      }));
+
+      bench_report("v1", "to_aos", SIZE, ALIGN, bench_measure([&] {
+        for (size_t i = 0; i < SIZE; ++i) {
+          SoAEntry e = (*soa)[i];
+          output[i] = bench_element{ e.x, e.y, e.z, e.colour, e.value, e.name };
+        }
+        bench_keep(output);
+      }));
+    }
+  };
+
+}  // namespace
+
+void bench_v1() {
+  bench_sweep<runner>();
+}
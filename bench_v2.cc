@@ -0,0 +1,30 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "soa_v2.h"
+
+#include "bench.h"
+
+/*
+ * Structure-of-Arrays with accessors to the "rows" and "columns", as in test_v2.cc
+ */
+
+namespace {
+
+  struct runner {
+    template <size_t SIZE, size_t ALIGN>
+    static void run() {
+      std::unique_ptr<SoA<SIZE, ALIGN>> soa(new SoA<SIZE, ALIGN>);
+      std::unique_ptr<SoA<SIZE, ALIGN>> other(new SoA<SIZE, ALIGN>);
+      bench_fill(*soa, SIZE);
+      bench_columns("v2", *soa, SIZE, ALIGN);
+      bench_elements("v2", *soa, *other, SIZE, ALIGN);
+    }
+  };
+
+}  // namespace
+
+void bench_v2() {
+  bench_sweep<runner>();
+}
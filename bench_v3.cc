@@ -0,0 +1,38 @@
+#include <cstdint>
+#include <memory>
+
+#include "soa_v3.h"
+
+#include "bench.h"
+
+/*
+ * Structure-of-Arrays generated by the DECLARE_SOA_TEMPLATE macro, as in test_v3.cc
+ */
+
+DECLARE_SOA_TEMPLATE(SoAv3,
+  (double, x),
+  (double, y),
+  (double, z),
+  (uint16_t, colour),
+  (int32_t, value),
+  (const char *, name)
+);
+
+namespace {
+
+  struct runner {
+    template <size_t SIZE, size_t ALIGN>
+    static void run() {
+      std::unique_ptr<SoAv3<SIZE, ALIGN>> soa(new SoAv3<SIZE, ALIGN>);
+      std::unique_ptr<SoAv3<SIZE, ALIGN>> other(new SoAv3<SIZE, ALIGN>);
+      bench_fill(*soa, SIZE);
+      bench_columns("v3", *soa, SIZE, ALIGN);
+      bench_elements("v3", *soa, *other, SIZE, ALIGN);
+    }
+  };
+
+}  // namespace
+
+void bench_v3() {
+  bench_sweep<runner>();
+}
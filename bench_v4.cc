@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "soa_v4.h"
+#include "soa_algorithm.h"
+
+#include "bench.h"
+
+/*
+ * Structure-of-Arrays generated by the declare_SoA_template macro, as in test_v4.cc, with a compile-time size, with a
+ * runtime size and the fields sorted by alignment, and tiled
+ */
+
+declare_SoA_template(SoAv4,
+  // columns: one value per element
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int32_t, value),
+  SoA_column(const char *, name),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+namespace {
+
+  // filter, sort and AoS <-> SoA conversion kernels, using the bulk operations
+  template <typename SOA>
+  void bench_algorithms(const char* layout, SOA& soa, SOA& other, size_t size, size_t alignment) {
+    auto const& input = bench_input(size);
+    std::vector<bench_element> output(size);
+
+    bench_report(layout, "filter", size, alignment, bench_measure([&] {
+      size_t count = soa_filter(soa, other, [](auto const& e) { return e.value() > bench_threshold; });
+      bench_keep(count);
+    }));
+
+    bench_report(layout, "sort", size, alignment, bench_measure(
+      [&] { soa.from_aos(input.data(), size); },
+      [&] {
+        soa_sort_by(soa, &SoAv4View::value);
+        bench_keep(soa);
+      }));
+
+    bench_report(layout, "from_aos", size, alignment, bench_measure([&] {
+      soa.from_aos(input.data(), size);
+      bench_keep(soa);
+    }));
+
+    bench_report(layout, "to_aos", size, alignment, bench_measure([&] {
+      soa.to_aos(output.data(), size);
+      bench_keep(output);
+    }));
+  }
+
+  // runtime-sized SoA in a single buffer
+  template <typename LAYOUT>
+  struct buffer {
+    buffer(size_t elements) :
+      data_(static_cast<std::byte*>(std::aligned_alloc(LAYOUT::buffer_alignment, LAYOUT::compute_data_size(elements)))),
+      layout_(data_.get(), elements)
+    {}
+
+    struct deleter {
+      void operator()(std::byte* data) const { std::free(data); }
+    };
+
+    std::unique_ptr<std::byte, deleter> data_;
+    LAYOUT layout_;
+  };
+
+  struct runner {
+    template <size_t SIZE, size_t ALIGN>
+    static void run() {
+      {
+        std::unique_ptr<SoAv4<SIZE, ALIGN>> soa(new SoAv4<SIZE, ALIGN>);
+        std::unique_ptr<SoAv4<SIZE, ALIGN>> other(new SoAv4<SIZE, ALIGN>);
+        soa->from_aos(bench_input(SIZE).data(), SIZE);
+        bench_columns("v4", *soa, SIZE, ALIGN);
+        bench_algorithms("v4", *soa, *other, SIZE, ALIGN);
+      }
+      {
+        using Layout = SoAv4Layout<ALIGN, soa_alignment_order>;
+        buffer<Layout> soa(SIZE);
+        buffer<Layout> other(SIZE);
+        soa.layout_.from_aos(bench_input(SIZE).data(), SIZE);
+        bench_columns("v4-layout", soa.layout_, SIZE, ALIGN);
+        bench_algorithms("v4-layout", soa.layout_, other.layout_, SIZE, ALIGN);
+      }
+      {
+        using Tiled = SoAv4Tiled<16, ALIGN>;
+        buffer<Tiled> soa(SIZE);
+        bench_fill(soa.layout_, SIZE);
+        bench_columns("v4-tiled", soa.layout_, SIZE, ALIGN);
+      }
+    }
+  };
+
+}  // namespace
+
+void bench_v4() {
+  bench_sweep<runner>();
+}
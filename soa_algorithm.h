@@ -0,0 +1,335 @@
+/*
+ * Column-wise algorithms over the SoA types generated by declare_SoA_template: each operation first
+ * works out which elements are involved, then processes one column at a time.
+ *
+ * The algorithms accept any SoA type with a view() method (the compile-time sized SoA, the runtime
+ * sized layout, and the views), and operate on the columns through view().columns().
+ */
+
+#ifndef SOA_ALGORITHM_H
+#define SOA_ALGORITHM_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// how the algorithms that write whole columns store their output
+enum class soa_store_policy {
+  normal,               // regular stores, through the caches
+  streaming             // non-temporal stores, bypassing the caches, for large output that is not read again soon
+};
+
+namespace soa_detail {
+
+  template <typename A, typename B, typename F, size_t... I>
+  void zip(A const& a, B const& b, F&& f, std::index_sequence<I...>) {
+    (f(std::get<I>(a), std::get<I>(b)), ...);
+  }
+
+  // call f(a, b) for each pair of corresponding elements of the tuples `a` and `b`
+  template <typename A, typename B, typename F>
+  void zip(A const& a, B const& b, F&& f) {
+    static_assert(std::tuple_size_v<A> == std::tuple_size_v<B>, "the SoA types must have the same columns");
+    zip(a, b, std::forward<F>(f), std::make_index_sequence<std::tuple_size_v<A>>{});
+  }
+
+  // call f(a) for each element of the tuple `a`
+  template <typename A, typename F>
+  void for_each(A const& a, F&& f) {
+    std::apply([&f](auto... element) { (f(element), ...); }, a);
+  }
+
+  // type of the values of a column: the type pointed to, or the value_type of the bit-packed columns
+  template <typename COLUMN, typename = void>
+  struct column_value {
+    using type = std::remove_const_t<std::remove_pointer_t<COLUMN>>;
+  };
+
+  template <typename COLUMN>
+  struct column_value<COLUMN, std::void_t<typename COLUMN::packed_type>> {
+    using type = typename COLUMN::value_type;
+  };
+
+  template <typename COLUMN>
+  using column_value_t = typename column_value<COLUMN>::type;
+
+#if defined(__AVX512F__)
+  constexpr size_t stream_width = 64;
+#elif defined(__AVX__)
+  constexpr size_t stream_width = 32;
+#else
+  constexpr size_t stream_width = 16;
+#endif
+
+  // store the stream_width bytes at `in` to `out`, aligned to stream_width, with a non-temporal store
+  inline void stream_block(std::byte* out, std::byte const* in) {
+#if defined(__AVX512F__)
+    _mm512_stream_si512(reinterpret_cast<__m512i*>(out), _mm512_loadu_si512(in));
+#elif defined(__AVX__)
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(out), _mm256_loadu_si256(reinterpret_cast<__m256i const*>(in)));
+#elif defined(__SSE2__)
+    _mm_stream_si128(reinterpret_cast<__m128i*>(out), _mm_loadu_si128(reinterpret_cast<__m128i const*>(in)));
+#else
+    std::memcpy(out, in, stream_width);
+#endif
+  }
+
+  // order the non-temporal stores before any later store, e.g. the one that hands the output over to another thread
+  inline void stream_fence() {
+#if defined(__SSE2__)
+    _mm_sfence();
+#endif
+  }
+
+  // number of bytes from `out` to the next address aligned to stream_width
+  inline size_t stream_offset(void const* out) {
+    return (stream_width - reinterpret_cast<uintptr_t>(out) % stream_width) % stream_width;
+  }
+
+  // copy `bytes` bytes with non-temporal stores; the unaligned head and tail of `out` use regular stores, so the columns
+  // aligned to at least stream_width are streamed in full
+  inline void stream_copy(std::byte* out, std::byte const* in, size_t bytes) {
+    size_t i = std::min(bytes, stream_offset(out));
+    std::memcpy(out, in, i);
+    for (; i + stream_width <= bytes; i += stream_width)
+      stream_block(out + i, in + i);
+    std::memcpy(out + i, in + i, bytes - i);
+  }
+
+  // copy the first `count` elements of a column; the bit-packed columns are copied a whole word at a time when both start
+  // on a word boundary, and one element at a time otherwise
+  template <typename OUT, typename IN>
+  void copy_column(OUT out, IN in, size_t count, soa_store_policy policy = soa_store_policy::normal) {
+    auto copy = [policy](void* out, void const* in, size_t bytes) {
+      if (policy == soa_store_policy::streaming)
+        stream_copy(static_cast<std::byte*>(out), static_cast<std::byte const*>(in), bytes);
+      else if (bytes)
+        std::memcpy(out, in, bytes);
+    };
+    if constexpr (std::is_pointer_v<OUT>) {
+      static_assert(std::is_trivially_copyable_v<std::remove_pointer_t<OUT>>, "the columns must be trivially copyable");
+      copy(out, in, sizeof(*out) * count);
+    } else {
+      constexpr size_t bits = OUT::packed_type::bits;
+      size_t i = 0;
+      if (out.first() * bits % 64 == 0 and in.first() * bits % 64 == 0) {
+        size_t words = count * bits / 64;
+        copy(out.words() + out.first() * bits / 64, in.words() + in.first() * bits / 64, words * sizeof(uint64_t));
+        i = words * 64 / bits;
+      }
+      for (; i < count; ++i)
+        out[i] = in[i];
+    }
+  }
+
+  // set the first `count` elements of a column to `value`; with the streaming policy, the elements in the blocks of the
+  // column aligned to stream_width are written with non-temporal stores, and so are the whole words of the bit-packed
+  // columns whose number of bits divides 64
+  template <typename OUT, typename T>
+  void fill_column(OUT out, size_t count, T const& value, soa_store_policy policy = soa_store_policy::normal) {
+    size_t i = 0;
+    if constexpr (not std::is_pointer_v<OUT>) {
+      using packed_type = typename OUT::packed_type;
+      constexpr size_t bits = packed_type::bits;
+      if constexpr (64 % bits == 0) {
+        constexpr size_t per_word = 64 / bits;
+        if (policy == soa_store_policy::streaming) {
+          // the elements up to the first word boundary, then a word holding per_word copies of the value
+          size_t head = std::min(count, (per_word - out.first() % per_word) % per_word);
+          for (; i < head; ++i)
+            out[i] = value;
+          uint64_t word = 0;
+          for (size_t k = 0; k < per_word; ++k)
+            word |= (static_cast<uint64_t>(static_cast<typename packed_type::value_type>(value)) & packed_type::mask) << (k * bits);
+          size_t words = (count - i) / per_word;
+          fill_column(out.words() + (out.first() + i) / per_word, words, word, policy);
+          i += words * per_word;
+        }
+      }
+    } else {
+      using U = std::remove_pointer_t<OUT>;
+      static_assert(std::is_trivially_copyable_v<U>, "the columns must be trivially copyable");
+      if constexpr (stream_width % sizeof(U) == 0) {
+        if (policy == soa_store_policy::streaming and stream_offset(out) % sizeof(U) == 0) {
+          // a block of stream_width bytes holding copies of the value
+          alignas(stream_width) U pattern[stream_width / sizeof(U)];
+          std::fill(std::begin(pattern), std::end(pattern), static_cast<U>(value));
+          size_t head = std::min(count, stream_offset(out) / sizeof(U));
+          for (; i < head; ++i)
+            out[i] = value;
+          auto const* block = reinterpret_cast<std::byte const*>(pattern);
+          for (; i + std::size(pattern) <= count; i += std::size(pattern))
+            stream_block(reinterpret_cast<std::byte*>(out + i), block);
+        }
+      }
+    }
+    for (; i < count; ++i)
+      out[i] = value;
+  }
+
+}  // namespace soa_detail
+
+
+// indices of the elements of `soa` for which pred(element) is true, in increasing order;
+// the loop does not branch on the result of the predicate
+template <typename SOA, typename PRED>
+std::vector<size_t> soa_select(SOA const& soa, PRED&& pred) {
+  auto view = soa.view();
+  size_t size = view.size();
+  std::vector<size_t> indices(size);
+  size_t count = 0;
+  for (size_t i = 0; i < size; ++i) {
+    indices[count] = i;
+    count += static_cast<bool>(pred(view[i]));
+  }
+  indices.resize(count);
+  return indices;
+}
+
+// copy the elements of `source` at the given indices to the first indices.size() elements of `destination`,
+// one column at a time; `destination` may be the same SoA as `source` if the indices are increasing
+template <typename SOURCE, typename DESTINATION>
+void soa_gather(SOURCE const& source, DESTINATION&& destination, std::vector<size_t> const& indices) {
+  auto input = source.view();
+  auto output = destination.view();
+  assert(output.size() >= indices.size());
+  size_t count = indices.size();
+  size_t const* index = indices.data();
+  soa_detail::zip(output.columns(), input.columns(), [count, index](auto out, auto in) {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = in[index[i]];
+  });
+}
+
+// copy the elements of `source` for which pred(element) is true to the first elements of `destination`, and its scalars;
+// return the number of elements copied
+template <typename SOURCE, typename DESTINATION, typename PRED>
+size_t soa_filter(SOURCE const& source, DESTINATION&& destination, PRED&& pred) {
+  auto indices = soa_select(source, std::forward<PRED>(pred));
+  soa_gather(source, destination, indices);
+  soa_detail::zip(destination.view().scalars(), source.view().scalars(), [](auto* out, auto const* in) { *out = *in; });
+  return indices.size();
+}
+
+// copy the elements [first, first + count) of `source` to the same elements of `destination`, one column at a time; the
+// two SoAs must be generated by the same declaration, but can have different sizes and alignments, and be owning SoAs or
+// views; with the streaming policy the columns of `destination` are written with non-temporal stores, followed by a fence
+template <typename DESTINATION, typename SOURCE>
+void soa_copy(DESTINATION&& destination, SOURCE const& source, size_t first, size_t count,
+              soa_store_policy policy = soa_store_policy::normal) {
+  auto input = source.view();
+  auto output = destination.view();
+  static_assert(std::is_same_v<typename decltype(input)::value_type, typename decltype(output)::value_type>,
+                "the SoA types must be generated by the same declaration");
+  assert(first + count <= input.size() and first + count <= output.size());
+  soa_detail::zip(output.columns(), input.columns(), [first, count, policy](auto out, auto in) {
+    soa_detail::copy_column(out + first, in + first, count, policy);
+  });
+  if (policy == soa_store_policy::streaming)
+    soa_detail::stream_fence();
+}
+
+// copy all the elements of `source` to the first elements of `destination`, and its scalars
+template <typename DESTINATION, typename SOURCE>
+void soa_copy(DESTINATION&& destination, SOURCE const& source, soa_store_policy policy = soa_store_policy::normal) {
+  soa_copy(destination, source, 0, source.view().size(), policy);
+  soa_detail::zip(destination.view().scalars(), source.view().scalars(), [](auto* out, auto const* in) { *out = *in; });
+}
+
+// set the elements [first, first + count) of the column returned by column(destination.view()), for example &SoAView::x,
+// to `value`; with the streaming policy the column is written with non-temporal stores, followed by a fence
+template <typename DESTINATION, typename COLUMN, typename T>
+void soa_fill(DESTINATION&& destination, size_t first, size_t count, COLUMN&& column, T const& value,
+              soa_store_policy policy = soa_store_policy::normal) {
+  auto view = destination.view();
+  assert(first + count <= view.size());
+  soa_detail::fill_column(std::invoke(std::forward<COLUMN>(column), view) + first, count, value, policy);
+  if (policy == soa_store_policy::streaming)
+    soa_detail::stream_fence();
+}
+
+// set all the elements of the column returned by column(destination.view()) to `value`
+template <typename DESTINATION, typename COLUMN, typename T>
+void soa_fill(DESTINATION&& destination, COLUMN&& column, T const& value, soa_store_policy policy = soa_store_policy::normal) {
+  soa_fill(destination, 0, destination.view().size(), std::forward<COLUMN>(column), value, policy);
+}
+
+// move the elements of `soa` for which pred(element) is true to its first elements, preserving their order;
+// return the number of elements kept
+template <typename SOA, typename PRED>
+size_t soa_compact(SOA&& soa, PRED&& pred) {
+  auto indices = soa_select(soa, std::forward<PRED>(pred));
+  soa_gather(soa, soa, indices);
+  return indices.size();
+}
+
+// reorder the elements of `soa` so that its i-th element becomes the element that was at permutation[i],
+// one column at a time
+template <typename SOA>
+void soa_apply_permutation(SOA&& soa, std::vector<size_t> const& permutation) {
+  auto view = soa.view();
+  size_t size = view.size();
+  assert(permutation.size() == size);
+
+  // scratch space large enough for the values of any column; the bit-packed columns are unpacked into it
+  size_t bytes = 0;
+  soa_detail::for_each(view.columns(), [&](auto column) {
+    bytes = std::max(bytes, sizeof(soa_detail::column_value_t<decltype(column)>) * size);
+  });
+  std::unique_ptr<std::byte[]> scratch(new std::byte[bytes]);
+
+  size_t const* index = permutation.data();
+  soa_detail::for_each(view.columns(), [&](auto column) {
+    using T = soa_detail::column_value_t<decltype(column)>;
+    static_assert(std::is_trivially_copyable_v<T>, "the columns must be trivially copyable");
+    T* buffer = reinterpret_cast<T*>(scratch.get());
+    for (size_t i = 0; i < size; ++i)
+      buffer[i] = column[index[i]];
+    if constexpr (std::is_pointer_v<decltype(column)>)
+      std::memcpy(column, buffer, sizeof(T) * size);
+    else
+      for (size_t i = 0; i < size; ++i)
+        column[i] = buffer[i];
+  });
+}
+
+// permutation that sorts the elements of `soa` by the values of the key column returned by key(soa.view()), according
+// to `compare`; elements with equivalent keys keep their relative order
+template <typename SOA, typename KEY, typename COMPARE = std::less<>>
+std::vector<size_t> soa_sort_permutation(SOA&& soa, KEY&& key, COMPARE&& compare = COMPARE()) {
+  auto view = soa.view();
+  size_t size = view.size();
+  auto column = std::invoke(std::forward<KEY>(key), view);
+  using T = soa_detail::column_value_t<decltype(column)>;
+
+  // sort the (narrow) keys together with their indices, rather than the whole elements
+  std::vector<std::pair<T, size_t>> keys(size);
+  for (size_t i = 0; i < size; ++i)
+    keys[i] = { column[i], i };
+  std::stable_sort(keys.begin(), keys.end(), [&compare](auto const& a, auto const& b) { return compare(a.first, b.first); });
+
+  std::vector<size_t> permutation(size);
+  for (size_t i = 0; i < size; ++i)
+    permutation[i] = keys[i].second;
+  return permutation;
+}
+
+// sort the elements of `soa` by the values of the key column returned by key(soa.view()), for example &SoAView::z
+template <typename SOA, typename KEY, typename COMPARE = std::less<>>
+void soa_sort_by(SOA&& soa, KEY&& key, COMPARE&& compare = COMPARE()) {
+  soa_apply_permutation(soa, soa_sort_permutation(soa, std::forward<KEY>(key), std::forward<COMPARE>(compare)));
+}
+
+#endif  // SOA_ALGORITHM_H
@@ -0,0 +1,309 @@
+/*
+ * Lightweight encodings for individual SoA columns, for storage and transfer.
+ *
+ * Each column is encoded into a self-describing block of bytes, and decoded directly into the column of a destination
+ * SoA. Apart from the run-length decoder, the decoding loops have no data-dependent branches, so that the compiler can
+ * vectorise them. The codec can be chosen at compile time, soa_encode<CODEC>(data, count), so that the combinations of
+ * codecs and types that are not supported do not compile, or at runtime.
+ */
+
+#ifndef SOA_CODEC_H
+#define SOA_CODEC_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+enum class soa_codec : uint8_t {
+  raw,                  // the values, as they are
+  frame_of_reference,   // integers: the difference from the minimum value, bit-packed
+  delta,                // integers: the zig-zag encoded difference from the previous value, bit-packed
+  run_length,           // the value and the length of each run of equal values
+  byte_shuffle          // the first byte of all the values, then the second byte of all the values, and so on
+};
+
+// header at the beginning of each encoded column
+struct soa_codec_header {
+  soa_codec codec;
+  uint8_t width;          // number of bits of each bit-packed value
+  uint8_t type_size;      // sizeof() the type of the values
+  uint8_t unused[5];
+  uint64_t count;         // number of values
+  uint64_t reference;     // frame_of_reference: the minimum value; delta: the first value; run_length: the number of runs
+};
+
+namespace soa_detail {
+
+  // number of bits needed to represent `value`
+  inline unsigned bit_width(uint64_t value) {
+    return value ? 64 - __builtin_clzll(value) : 0;
+  }
+
+  inline uint64_t low_bits(unsigned width) {
+    return (width >= 64) ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+  }
+
+  // number of bytes written by bit_pack()
+  inline size_t bit_packed_size(size_t count, unsigned width) {
+    return ((count * width + 63) / 64 + 1) * sizeof(uint64_t);
+  }
+
+  // pack `count` values of `width` bits each, starting from the least significant bits of each word; one extra word is
+  // appended, so that the decoder can always read two consecutive words
+  inline void bit_pack(uint64_t const* values, size_t count, unsigned width, std::vector<std::byte>& out) {
+    size_t words = bit_packed_size(count, width) / sizeof(uint64_t);
+    std::vector<uint64_t> packed(words, 0);
+    for (size_t i = 0; i < count; ++i) {
+      size_t bit = i * width;
+      size_t word = bit / 64;
+      unsigned shift = bit % 64;
+      packed[word] |= values[i] << shift;
+      if (shift + width > 64)
+        packed[word + 1] |= values[i] >> (64 - shift);
+    }
+    size_t offset = out.size();
+    out.resize(offset + words * sizeof(uint64_t));
+    std::memcpy(out.data() + offset, packed.data(), words * sizeof(uint64_t));
+  }
+
+  // unpack `count` values of `width` bits each, and pass them to out(i, value) one at a time
+  template <typename OUT>
+  void bit_unpack(std::byte const* in, size_t count, unsigned width, OUT&& out) {
+    // all the values are 0, e.g. a constant column or a single value: there is nothing to read
+    if (width == 0) {
+      for (size_t i = 0; i < count; ++i)
+        out(i, uint64_t(0));
+      return;
+    }
+    // the encoded buffer may not be aligned to 8 bytes
+    auto load = [in](size_t word) {
+      uint64_t value;
+      std::memcpy(&value, in + word * sizeof(uint64_t), sizeof(uint64_t));
+      return value;
+    };
+    uint64_t mask = low_bits(width);
+    for (size_t i = 0; i < count; ++i) {
+      size_t bit = i * width;
+      size_t word = bit / 64;
+      unsigned shift = bit % 64;
+      // (hi << 1) << (63 - shift) avoids an undefined shift by 64 bits when shift is 0
+      out(i, ((load(word) >> shift) | ((load(word + 1) << 1) << (63 - shift))) & mask);
+    }
+  }
+
+  template <typename T>
+  constexpr bool is_codec_integer = std::is_integral_v<T> and not std::is_same_v<T, bool> and sizeof(T) <= sizeof(uint64_t);
+
+}  // namespace soa_detail
+
+// true if the values of type T can be encoded with CODEC: frame_of_reference and delta only support integer types
+template <soa_codec CODEC, typename T>
+constexpr bool soa_codec_supports =
+    std::is_trivially_copyable_v<T> and
+    (soa_detail::is_codec_integer<T> or (CODEC != soa_codec::frame_of_reference and CODEC != soa_codec::delta));
+
+// encode the `count` values starting at `data` with the given codec
+template <soa_codec CODEC, typename T>
+std::vector<std::byte> soa_encode(T const* data, size_t count) {
+  static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable types can be encoded");
+  static_assert(soa_codec_supports<CODEC, T>, "frame_of_reference and delta are only supported for integer types");
+  using U = std::make_unsigned_t<std::conditional_t<soa_detail::is_codec_integer<T>, T, int>>;
+
+  soa_codec_header header{};
+  header.codec = CODEC;
+  header.type_size = sizeof(T);
+  header.count = count;
+  std::vector<std::byte> out(sizeof(header));
+
+  if constexpr (CODEC == soa_codec::raw) {
+    out.resize(sizeof(header) + sizeof(T) * count);
+    std::memcpy(out.data() + sizeof(header), data, sizeof(T) * count);
+
+  } else if constexpr (CODEC == soa_codec::frame_of_reference) {
+    T min = count ? *std::min_element(data, data + count) : T();
+    T max = count ? *std::max_element(data, data + count) : T();
+    std::vector<uint64_t> values(count);
+    for (size_t i = 0; i < count; ++i)
+      values[i] = static_cast<U>(static_cast<U>(data[i]) - static_cast<U>(min));
+    header.width = soa_detail::bit_width(static_cast<U>(static_cast<U>(max) - static_cast<U>(min)));
+    header.reference = static_cast<U>(min);
+    soa_detail::bit_pack(values.data(), count, header.width, out);
+
+  } else if constexpr (CODEC == soa_codec::delta) {
+    using S = std::make_signed_t<U>;
+    std::vector<uint64_t> values(count);
+    uint64_t max = 0;
+    for (size_t i = 1; i < count; ++i) {
+      S difference = static_cast<S>(static_cast<U>(static_cast<U>(data[i]) - static_cast<U>(data[i - 1])));
+      // zig-zag encoding: 0, -1, 1, -2, 2, ... become 0, 1, 2, 3, 4, ...
+      values[i] = static_cast<U>((static_cast<U>(difference) << 1) ^ static_cast<U>(difference >> (sizeof(S) * 8 - 1)));
+      max = std::max(max, values[i]);
+    }
+    header.width = soa_detail::bit_width(max);
+    header.reference = count ? static_cast<U>(data[0]) : 0;
+    soa_detail::bit_pack(values.data(), count, header.width, out);
+
+  } else if constexpr (CODEC == soa_codec::run_length) {
+    // the values of the runs, followed by their lengths
+    std::vector<T> values;
+    std::vector<uint32_t> lengths;
+    for (size_t i = 0; i < count; ++i) {
+      if (values.empty() or not (data[i] == values.back()) or lengths.back() == std::numeric_limits<uint32_t>::max()) {
+        values.push_back(data[i]);
+        lengths.push_back(0);
+      }
+      ++lengths.back();
+    }
+    header.reference = values.size();
+    out.resize(sizeof(header) + sizeof(T) * values.size() + sizeof(uint32_t) * lengths.size());
+    std::memcpy(out.data() + sizeof(header), values.data(), sizeof(T) * values.size());
+    std::memcpy(out.data() + sizeof(header) + sizeof(T) * values.size(), lengths.data(), sizeof(uint32_t) * lengths.size());
+
+  } else if constexpr (CODEC == soa_codec::byte_shuffle) {
+    out.resize(sizeof(header) + sizeof(T) * count);
+    auto const* bytes = reinterpret_cast<std::byte const*>(data);
+    std::byte* shuffled = out.data() + sizeof(header);
+    for (size_t b = 0; b < sizeof(T); ++b)
+      for (size_t i = 0; i < count; ++i)
+        shuffled[b * count + i] = bytes[i * sizeof(T) + b];
+  }
+
+  std::memcpy(out.data(), &header, sizeof(header));
+  return out;
+}
+
+// encode the `count` values starting at `data` with a codec chosen at runtime; throw std::invalid_argument if the codec
+// does not support the type T
+template <typename T>
+std::vector<std::byte> soa_encode(soa_codec codec, T const* data, size_t count) {
+  switch (codec) {
+  case soa_codec::raw:
+    return soa_encode<soa_codec::raw>(data, count);
+  case soa_codec::frame_of_reference:
+    if constexpr (soa_codec_supports<soa_codec::frame_of_reference, T>)
+      return soa_encode<soa_codec::frame_of_reference>(data, count);
+    break;
+  case soa_codec::delta:
+    if constexpr (soa_codec_supports<soa_codec::delta, T>)
+      return soa_encode<soa_codec::delta>(data, count);
+    break;
+  case soa_codec::run_length:
+    return soa_encode<soa_codec::run_length>(data, count);
+  case soa_codec::byte_shuffle:
+    return soa_encode<soa_codec::byte_shuffle>(data, count);
+  }
+  throw std::invalid_argument("the codec does not support the type of the values");
+}
+
+namespace soa_detail {
+
+  inline soa_codec_header read_codec_header(std::byte const* encoded, size_t size) {
+    soa_codec_header header;
+    if (size < sizeof(header))
+      throw std::runtime_error("truncated encoded column");
+    std::memcpy(&header, encoded, sizeof(header));
+    return header;
+  }
+
+}  // namespace soa_detail
+
+// number of values in the encoded column of `size` bytes starting at `encoded`
+inline size_t soa_decoded_count(std::byte const* encoded, size_t size) {
+  return soa_detail::read_codec_header(encoded, size).count;
+}
+
+inline size_t soa_decoded_count(std::vector<std::byte> const& encoded) {
+  return soa_decoded_count(encoded.data(), encoded.size());
+}
+
+// decode the encoded column of `size` bytes starting at `encoded` into the `count` values starting at `data`, e.g. the
+// column of a SoA; throw std::runtime_error if the encoded column does not hold `count` values of type T, is truncated or
+// corrupted, or was encoded from a type for which its codec is not supported; nothing is written to `data` in that case
+template <typename T>
+void soa_decode(std::byte const* encoded, size_t size, T* data, size_t count) {
+  using U = std::make_unsigned_t<std::conditional_t<soa_detail::is_codec_integer<T>, T, int>>;
+
+  soa_codec_header header = soa_detail::read_codec_header(encoded, size);
+  if (header.type_size != sizeof(T) or header.count != count)
+    throw std::runtime_error("the encoded column does not hold the values of the destination");
+  std::byte const* payload = encoded + sizeof(header);
+  size_t payload_size = size - sizeof(header);
+
+  switch (header.codec) {
+  case soa_codec::raw:
+    if (payload_size < sizeof(T) * count)
+      break;
+    std::memcpy(data, payload, sizeof(T) * count);
+    return;
+
+  case soa_codec::frame_of_reference:
+    if constexpr (soa_codec_supports<soa_codec::frame_of_reference, T>) {
+      if (header.width > sizeof(T) * 8 or payload_size < soa_detail::bit_packed_size(count, header.width))
+        break;
+      // unpack the values and add the reference directly into the destination column
+      U reference = static_cast<U>(header.reference);
+      soa_detail::bit_unpack(payload, count, header.width, [data, reference](size_t i, uint64_t value) {
+        data[i] = static_cast<T>(static_cast<U>(reference + static_cast<U>(value)));
+      });
+      return;
+    }
+    break;
+
+  case soa_codec::delta:
+    if constexpr (soa_codec_supports<soa_codec::delta, T>) {
+      if (header.width > sizeof(T) * 8 or payload_size < soa_detail::bit_packed_size(count, header.width))
+        break;
+      U value = static_cast<U>(header.reference);
+      soa_detail::bit_unpack(payload, count, header.width, [data, &value](size_t i, uint64_t zigzag) {
+        value += static_cast<U>((static_cast<U>(zigzag) >> 1) ^ static_cast<U>(-static_cast<U>(zigzag & 1)));
+        data[i] = static_cast<T>(value);
+      });
+      return;
+    }
+    break;
+
+  case soa_codec::run_length: {
+    // each run holds at least one value
+    if (header.reference > count or payload_size < (sizeof(T) + sizeof(uint32_t)) * header.reference)
+      break;
+    size_t runs = header.reference;
+    std::vector<uint32_t> lengths(runs);
+    std::memcpy(lengths.data(), payload + sizeof(T) * runs, sizeof(uint32_t) * runs);
+    // check that the runs fill the destination exactly, before writing to it
+    uint64_t total = 0;
+    for (uint32_t length: lengths)
+      total += length;
+    if (total != count)
+      break;
+    for (size_t r = 0; r < runs; ++r) {
+      T value;
+      std::memcpy(&value, payload + sizeof(T) * r, sizeof(T));
+      data = std::fill_n(data, lengths[r], value);
+    }
+    return;
+  }
+
+  case soa_codec::byte_shuffle: {
+    if (payload_size < sizeof(T) * count)
+      break;
+    auto* bytes = reinterpret_cast<std::byte*>(data);
+    for (size_t b = 0; b < sizeof(T); ++b)
+      for (size_t i = 0; i < count; ++i)
+        bytes[i * sizeof(T) + b] = payload[b * count + i];
+    return;
+  }
+  }
+  throw std::runtime_error("corrupted or unsupported encoded column");
+}
+
+template <typename T>
+void soa_decode(std::vector<std::byte> const& encoded, T* data, size_t count) {
+  soa_decode(encoded.data(), encoded.size(), data, count);
+}
+
+#endif  // SOA_CODEC_H
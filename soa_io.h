@@ -0,0 +1,563 @@
+/*
+ * On-disk formats for SoAs, in the native byte order. Columns of pointers, like `const char *`, are written as they are,
+ * but their values are meaningless when the file is read by a different process.
+ *
+ * A SoA file holds a header, the description of each field, and the fields of a SoA laid out exactly as in the buffer
+ * of the LAYOUT type used to write it, e.g. SoALayout<64>, starting at a page boundary; it is mapped back into memory
+ * without any deserialisation.
+ *
+ * A SoA stream holds a header, the description of each field, the scalars, and a sequence of chunks of up to a fixed
+ * number of elements, each one with its columns stored one after the other; it is written and read one chunk at a
+ * time, and can hold more elements than fit in memory.
+ */
+
+#ifndef SOA_IO_H
+#define SOA_IO_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "soa_v4.h"
+
+// identifies a SoA file, and the version of the format
+constexpr char soa_file_magic[8] = { 'S', 'o', 'A', 'f', 'i', 'l', 'e', '1' };
+
+// the data starts at a multiple of the page size, so it can be mapped with the same alignment it had in memory
+constexpr size_t soa_file_page_size = 4096;
+
+struct soa_file_header {
+  char magic[8];
+  uint64_t schema;          // hash of the description of the fields, see soa_schema_hash()
+  uint64_t elements;
+  uint64_t fields;
+  uint64_t alignment;       // alignment of the buffer
+  uint64_t data_offset;     // offset of the data from the beginning of the file
+  uint64_t data_size;
+};
+
+// description of each field, following the header
+struct soa_file_field {
+  uint64_t offset;          // offset of the field from the beginning of the data
+  uint64_t size;            // size of the field, in bytes
+  uint64_t alignment;
+};
+
+// FNV-1a hash of the names, types sizes and alignments, kinds, and packed bits of the fields
+template <size_t N>
+constexpr uint64_t soa_schema_hash(soa_field_info const (&fields)[N]) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  auto add = [&hash](uint64_t byte) {
+    hash ^= byte;
+    hash *= 0x100000001b3ull;
+  };
+  for (size_t i = 0; i < N; ++i) {
+    for (const char* c = fields[i].name; *c; ++c)
+      add(static_cast<unsigned char>(*c));
+    add(0);
+    for (int b = 0; b < 64; b += 8)
+      add((fields[i].size >> b) & 0xff);
+    for (int b = 0; b < 64; b += 8)
+      add((fields[i].alignment >> b) & 0xff);
+    add(fields[i].is_column);
+    // only for the bit-packed columns, leaving the hash of the other schemas unchanged
+    if (fields[i].bits)
+      add(fields[i].bits);
+  }
+  return hash;
+}
+
+namespace soa_detail {
+
+  [[noreturn]] inline void throw_io_error(std::string const& what, std::string const& path) {
+    throw std::runtime_error(what + " \"" + path + "\": " + std::strerror(errno));
+  }
+
+  inline void write_all(int fd, void const* data, size_t size, std::string const& path) {
+    auto const* bytes = static_cast<std::byte const*>(data);
+    while (size > 0) {
+      ssize_t written = ::write(fd, bytes, size);
+      if (written < 0) {
+        if (errno == EINTR)
+          continue;
+        throw_io_error("cannot write to", path);
+      }
+      bytes += written;
+      size -= written;
+    }
+  }
+
+  // pointers to the storage of the fields of a view, in declaration order; the bit-packed columns point to their words
+  template <typename VIEW>
+  std::vector<void const*> field_pointers(VIEW const& view) {
+    auto to_array = [](auto... pointers) {
+      return std::vector<void const*>{ static_cast<void const*>(column_storage(pointers, 0).first)... };
+    };
+    auto columns = std::apply(to_array, view.columns());
+    auto scalars = std::apply(to_array, view.scalars());
+    std::vector<void const*> result;
+    size_t c = 0, s = 0;
+    for (auto const& field: VIEW::fields)
+      result.push_back(field.is_column ? columns[c++] : scalars[s++]);
+    return result;
+  }
+
+  // header and field descriptions of a SoA of type LAYOUT with the given number of elements
+  template <typename LAYOUT>
+  std::pair<soa_file_header, std::vector<soa_file_field>> file_description(size_t elements) {
+    auto const& fields = LAYOUT::fields;
+    auto offsets = LAYOUT::compute_offsets(elements);
+    soa_file_header header{};
+    std::memcpy(header.magic, soa_file_magic, sizeof(soa_file_magic));
+    header.schema = soa_schema_hash(fields);
+    header.elements = elements;
+    header.fields = std::size(fields);
+    header.alignment = LAYOUT::buffer_alignment;
+    header.data_offset = next_multiple(sizeof(soa_file_header) + sizeof(soa_file_field) * std::size(fields), soa_file_page_size);
+    header.data_size = offsets.back();
+    std::vector<soa_file_field> descriptions;
+    for (size_t i = 0; i < std::size(fields); ++i)
+      descriptions.push_back(soa_file_field{ offsets[i], field_extent(fields[i], elements), field_alignment(fields[i], LAYOUT::alignment) });
+    return { header, descriptions };
+  }
+
+}  // namespace soa_detail
+
+// write the elements and scalars of `soa` to the file at `path`, laid out as in the buffer of a LAYOUT, e.g. SoALayout<64>
+template <typename LAYOUT, typename SOA>
+void soa_write_file(std::string const& path, SOA const& soa) {
+  auto view = soa.view();
+  static_assert(soa_schema_hash(decltype(view)::fields) == soa_schema_hash(LAYOUT::fields), "the SoA must have the same fields as LAYOUT");
+  auto [header, descriptions] = soa_detail::file_description<LAYOUT>(view.size());
+  auto pointers = soa_detail::field_pointers(view);
+
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    soa_detail::throw_io_error("cannot create", path);
+  try {
+    soa_detail::write_all(fd, &header, sizeof(header), path);
+    soa_detail::write_all(fd, descriptions.data(), sizeof(soa_file_field) * descriptions.size(), path);
+    // the padding between the fields is written as zeros
+    std::vector<std::byte> padding(std::max<size_t>(header.alignment, soa_file_page_size));
+    size_t position = sizeof(header) + sizeof(soa_file_field) * descriptions.size();
+    auto pad = [&](size_t offset) {
+      soa_detail::write_all(fd, padding.data(), offset - position, path);
+      position = offset;
+    };
+    for (size_t i = 0; i < descriptions.size(); ++i) {
+      pad(header.data_offset + descriptions[i].offset);
+      soa_detail::write_all(fd, pointers[i], descriptions[i].size, path);
+      position += descriptions[i].size;
+    }
+    pad(header.data_offset + header.data_size);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  if (::close(fd) != 0)
+    soa_detail::throw_io_error("cannot write to", path);
+}
+
+// read-only memory mapping of a file written by soa_write_file<LAYOUT>(); the pages are loaded lazily, when they are
+// first accessed through the view
+template <typename LAYOUT>
+class soa_mapped_file {
+public:
+  using const_view_type = typename LAYOUT::const_view_type;
+
+  explicit soa_mapped_file(std::string const& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      soa_detail::throw_io_error("cannot open", path);
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+      ::close(fd);
+      soa_detail::throw_io_error("cannot open", path);
+    }
+    size_ = info.st_size;
+    mapping_ = (size_ > 0) ? ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+      mapping_ = nullptr;
+      throw std::runtime_error("cannot map \"" + path + "\"");
+    }
+    try {
+      validate(path);
+    } catch (...) {
+      ::munmap(mapping_, size_);
+      throw;
+    }
+    auto const& header = *static_cast<soa_file_header const*>(mapping_);
+    // the layout is only used to point the view to the fields, the data is never written
+    std::byte* data = static_cast<std::byte*>(mapping_) + header.data_offset;
+    view_ = LAYOUT(data, header.elements).view();
+  }
+
+  ~soa_mapped_file() {
+    if (mapping_)
+      ::munmap(mapping_, size_);
+  }
+
+  soa_mapped_file(soa_mapped_file const&) = delete;
+  soa_mapped_file& operator=(soa_mapped_file const&) = delete;
+
+  // number of elements
+  size_t size() const { return view_.size(); }
+
+  // read-only view over the mapped elements
+  const_view_type view() const { return view_; }
+
+private:
+  // check that the file was written with the same field declarations and layout as LAYOUT
+  void validate(std::string const& path) const {
+    if (size_ < sizeof(soa_file_header))
+      throw std::runtime_error("\"" + path + "\" is not a SoA file");
+    auto const& header = *static_cast<soa_file_header const*>(mapping_);
+    if (std::memcmp(header.magic, soa_file_magic, sizeof(soa_file_magic)) != 0)
+      throw std::runtime_error("\"" + path + "\" is not a SoA file");
+    if (header.schema != soa_schema_hash(LAYOUT::fields) or header.fields != std::size(LAYOUT::fields))
+      throw std::runtime_error("\"" + path + "\" holds a SoA with different fields");
+    auto [expected, descriptions] = soa_detail::file_description<LAYOUT>(header.elements);
+    auto const* fields = reinterpret_cast<soa_file_field const*>(&header + 1);
+    bool same = header.alignment == expected.alignment and header.data_offset == expected.data_offset and
+                header.data_size == expected.data_size;
+    for (size_t i = 0; same and i < descriptions.size(); ++i)
+      same = fields[i].offset == descriptions[i].offset and fields[i].size == descriptions[i].size and
+             fields[i].alignment == descriptions[i].alignment;
+    if (not same)
+      throw std::runtime_error("\"" + path + "\" holds a SoA with a different layout");
+    if (size_ < header.data_offset + header.data_size)
+      throw std::runtime_error("\"" + path + "\" is truncated");
+  }
+
+  void* mapping_ = nullptr;
+  size_t size_ = 0;
+  const_view_type view_;
+};
+
+// identifies a SoA stream, and the version of the format
+constexpr char soa_stream_magic[8] = { 'S', 'o', 'A', 's', 't', 'r', 'm', '1' };
+
+// alignment of the chunks, and of the columns inside each chunk
+constexpr size_t soa_stream_alignment = 64;
+
+struct soa_stream_header {
+  char magic[8];
+  uint64_t schema;          // hash of the description of the fields, see soa_schema_hash()
+  uint64_t fields;
+  uint64_t chunk_size;      // maximum number of elements in each chunk
+  uint64_t chunks;
+  uint64_t elements;
+  uint64_t data_offset;     // offset of the first chunk from the beginning of the file
+};
+
+// each chunk starts with a block of soa_stream_alignment bytes, holding the number of elements in the chunk, followed by
+// the columns, in declaration order, each one padded to soa_stream_alignment bytes
+
+namespace soa_detail {
+
+  inline void pwrite_all(int fd, void const* data, size_t size, size_t offset, std::string const& path) {
+    auto const* bytes = static_cast<std::byte const*>(data);
+    while (size > 0) {
+      ssize_t written = ::pwrite(fd, bytes, size, offset);
+      if (written < 0) {
+        if (errno == EINTR)
+          continue;
+        throw_io_error("cannot write to", path);
+      }
+      bytes += written;
+      offset += written;
+      size -= written;
+    }
+  }
+
+  inline void pread_all(int fd, void* data, size_t size, size_t offset, std::string const& path) {
+    auto* bytes = static_cast<std::byte*>(data);
+    while (size > 0) {
+      ssize_t read = ::pread(fd, bytes, size, offset);
+      if (read < 0 and errno == EINTR)
+        continue;
+      if (read <= 0)
+        throw std::runtime_error("cannot read from \"" + path + "\"");
+      bytes += read;
+      offset += read;
+      size -= read;
+    }
+  }
+
+  // size of a column of a chunk of `elements` elements inside a stream
+  inline size_t stream_column_extent(soa_field_info const& field, size_t elements) {
+    return next_multiple(field.size * elements, soa_stream_alignment);
+  }
+
+  // size of a chunk of `elements` elements inside a stream
+  template <size_t N>
+  size_t stream_chunk_extent(soa_field_info const (&fields)[N], size_t elements) {
+    size_t size = soa_stream_alignment;
+    for (size_t i = 0; i < N; ++i)
+      if (fields[i].is_column)
+        size += stream_column_extent(fields[i], elements);
+    return size;
+  }
+
+  // header and field descriptions of a stream of SoAs with the given fields; the scalars are stored one after the other
+  template <size_t N>
+  std::pair<soa_stream_header, std::vector<soa_file_field>> stream_description(soa_field_info const (&fields)[N], size_t chunk_size) {
+    soa_stream_header header{};
+    std::memcpy(header.magic, soa_stream_magic, sizeof(soa_stream_magic));
+    header.schema = soa_schema_hash(fields);
+    header.fields = N;
+    header.chunk_size = chunk_size;
+    std::vector<soa_file_field> descriptions;
+    size_t offset = sizeof(soa_stream_header) + sizeof(soa_file_field) * N;
+    for (size_t i = 0; i < N; ++i) {
+      if (fields[i].is_column) {
+        descriptions.push_back(soa_file_field{ 0, fields[i].size, fields[i].alignment });
+      } else {
+        offset = next_multiple(offset, fields[i].alignment);
+        descriptions.push_back(soa_file_field{ offset, fields[i].size, fields[i].alignment });
+        offset += fields[i].size;
+      }
+    }
+    header.data_offset = next_multiple(offset, soa_file_page_size);
+    return { header, descriptions };
+  }
+
+}  // namespace soa_detail
+
+// write SoAs with the fields of VIEW, e.g. SoAView, to a stream, in chunks of up to chunk_size elements
+template <typename VIEW>
+class soa_stream_writer {
+  static_assert(not soa_detail::has_packed_fields(VIEW::fields), "the streams do not support bit-packed columns");
+
+public:
+  soa_stream_writer(std::string const& path, size_t chunk_size) :
+    path_(path)
+  {
+    assert(chunk_size > 0);
+    std::tie(header_, fields_) = soa_detail::stream_description(VIEW::fields, chunk_size);
+    position_ = header_.data_offset;
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0)
+      soa_detail::throw_io_error("cannot create", path);
+  }
+
+  ~soa_stream_writer() {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+
+  soa_stream_writer(soa_stream_writer const&) = delete;
+  soa_stream_writer& operator=(soa_stream_writer const&) = delete;
+
+  // append all the elements of `soa`, and record the values of its scalars
+  template <typename SOA>
+  void append(SOA const& soa) {
+    auto view = soa.view();
+    static_assert(soa_schema_hash(decltype(view)::fields) == soa_schema_hash(VIEW::fields), "the SoA must have the same fields as VIEW");
+    assert(fd_ >= 0);
+    auto pointers = soa_detail::field_pointers(view);
+    for (size_t i = 0; i < fields_.size(); ++i)
+      if (not VIEW::fields[i].is_column)
+        soa_detail::pwrite_all(fd_, pointers[i], fields_[i].size, fields_[i].offset, path_);
+
+    for (size_t first = 0; first < view.size(); first += header_.chunk_size) {
+      size_t elements = std::min<size_t>(header_.chunk_size, view.size() - first);
+      uint64_t count = elements;
+      soa_detail::pwrite_all(fd_, &count, sizeof(count), position_, path_);
+      size_t offset = position_ + soa_stream_alignment;
+      for (size_t i = 0; i < fields_.size(); ++i) {
+        if (VIEW::fields[i].is_column) {
+          auto const* column = static_cast<std::byte const*>(pointers[i]) + fields_[i].size * first;
+          soa_detail::pwrite_all(fd_, column, fields_[i].size * elements, offset, path_);
+          offset += soa_detail::stream_column_extent(VIEW::fields[i], elements);
+        }
+      }
+      position_ = offset;
+      header_.chunks += 1;
+      header_.elements += elements;
+    }
+  }
+
+  // number of elements written so far
+  size_t size() const { return header_.elements; }
+
+  // write the header, and close the stream
+  void close() {
+    if (fd_ < 0)
+      return;
+    int fd = std::exchange(fd_, -1);
+    try {
+      soa_detail::pwrite_all(fd, &header_, sizeof(header_), 0, path_);
+      soa_detail::pwrite_all(fd, fields_.data(), sizeof(soa_file_field) * fields_.size(), sizeof(header_), path_);
+      // extend the file to the end of the last chunk, in case its padding was not written
+      if (::ftruncate(fd, position_) != 0)
+        soa_detail::throw_io_error("cannot write to", path_);
+    } catch (...) {
+      ::close(fd);
+      throw;
+    }
+    if (::close(fd) != 0)
+      soa_detail::throw_io_error("cannot write to", path_);
+  }
+
+private:
+  std::string path_;
+  int fd_ = -1;
+  soa_stream_header header_;
+  std::vector<soa_file_field> fields_;
+  size_t position_;         // offset of the next chunk
+};
+
+// read a stream written by a soa_stream_writer with the same fields as LAYOUT, e.g. SoALayout<64>, one chunk at a time;
+// only the selected columns are read from the file, and the next chunk is read in the background while the current one
+// is being used
+template <typename LAYOUT>
+class soa_stream_reader {
+  static_assert(not soa_detail::has_packed_fields(LAYOUT::fields), "the streams do not support bit-packed columns");
+
+public:
+  using const_view_type = typename LAYOUT::const_view_type;
+
+  // read only the columns with the given names, or all the columns if `columns` is empty
+  explicit soa_stream_reader(std::string const& path, std::vector<std::string> const& columns = {}) :
+    path_(path)
+  {
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0)
+      soa_detail::throw_io_error("cannot open", path);
+    try {
+      open(columns);
+    } catch (...) {
+      release();
+      throw;
+    }
+  }
+
+  ~soa_stream_reader() {
+    release();
+  }
+
+  soa_stream_reader(soa_stream_reader const&) = delete;
+  soa_stream_reader& operator=(soa_stream_reader const&) = delete;
+
+  // total number of elements, and maximum number of elements in each chunk
+  size_t size() const { return header_.elements; }
+  size_t chunk_size() const { return header_.chunk_size; }
+
+  // true if the column of the given field is read from the file
+  bool selected(size_t field) const { return selected_[field]; }
+
+  // read-only view over the next chunk, or an empty view after the last one; the view is valid until the following call;
+  // the columns that are not selected hold zeros
+  const_view_type next() {
+    if (not pending_.valid())
+      return const_view_type();
+    chunk current = pending_.get();
+    if (current.elements == 0)
+      return const_view_type();
+    size_t ready = filling_;
+    filling_ = 1 - filling_;
+    pending_ = std::async(std::launch::async, &soa_stream_reader::read, this, current.index + 1, current.next, buffers_[filling_]);
+    return LAYOUT(buffers_[ready], header_.chunk_size).view().subspan(0, current.elements);
+  }
+
+private:
+  struct chunk {
+    size_t index;
+    size_t elements;
+    size_t next;            // offset of the following chunk
+  };
+
+  void open(std::vector<std::string> const& columns) {
+    auto const& fields = LAYOUT::fields;
+    soa_detail::pread_all(fd_, &header_, sizeof(header_), 0, path_);
+    if (std::memcmp(header_.magic, soa_stream_magic, sizeof(soa_stream_magic)) != 0)
+      throw std::runtime_error("\"" + path_ + "\" is not a SoA stream");
+    if (header_.schema != soa_schema_hash(fields) or header_.fields != std::size(fields))
+      throw std::runtime_error("\"" + path_ + "\" holds a SoA with different fields");
+    std::vector<soa_file_field> descriptions(header_.fields);
+    soa_detail::pread_all(fd_, descriptions.data(), sizeof(soa_file_field) * descriptions.size(), sizeof(header_), path_);
+
+    for (size_t i = 0; i < std::size(fields); ++i) {
+      bool named = columns.empty();
+      for (auto const& column: columns)
+        named = named or column == fields[i].name;
+      selected_.push_back(fields[i].is_column and named);
+    }
+
+    // the scalars are read once, and copied to both buffers
+    offsets_ = LAYOUT::compute_offsets(header_.chunk_size);
+    size_t size = LAYOUT::compute_data_size(header_.chunk_size);
+    for (auto& buffer: buffers_) {
+      buffer = static_cast<std::byte*>(::operator new(size, std::align_val_t(LAYOUT::buffer_alignment)));
+      std::memset(buffer, 0, size);
+      for (size_t i = 0; i < std::size(fields); ++i)
+        if (not fields[i].is_column)
+          soa_detail::pread_all(fd_, buffer + offsets_[i], fields[i].size, descriptions[i].offset, path_);
+    }
+
+    filling_ = 0;
+    pending_ = std::async(std::launch::async, &soa_stream_reader::read, this, 0, header_.data_offset, buffers_[0]);
+  }
+
+  // read the selected columns of the chunk `index`, starting at `offset`, into `buffer`
+  chunk read(size_t index, size_t offset, std::byte* buffer) const {
+    if (index >= header_.chunks)
+      return chunk{ index, 0, offset };
+    auto const& fields = LAYOUT::fields;
+    uint64_t elements;
+    soa_detail::pread_all(fd_, &elements, sizeof(elements), offset, path_);
+    if (elements > header_.chunk_size)
+      throw std::runtime_error("\"" + path_ + "\" is corrupted");
+    size_t position = offset + soa_stream_alignment;
+    for (size_t i = 0; i < std::size(fields); ++i) {
+      if (not fields[i].is_column)
+        continue;
+      if (selected_[i])
+        soa_detail::pread_all(fd_, buffer + offsets_[i], fields[i].size * elements, position, path_);
+      position += soa_detail::stream_column_extent(fields[i], elements);
+    }
+    return chunk{ index, elements, position };
+  }
+
+  void release() {
+    if (pending_.valid())
+      pending_.wait();
+    for (auto& buffer: buffers_)
+      if (buffer)
+        ::operator delete(buffer, LAYOUT::compute_data_size(header_.chunk_size), std::align_val_t(LAYOUT::buffer_alignment));
+    if (fd_ >= 0)
+      ::close(fd_);
+  }
+
+  std::string path_;
+  int fd_ = -1;
+  soa_stream_header header_{};
+  std::vector<bool> selected_;
+  std::array<size_t, std::size(LAYOUT::fields) + 1> offsets_;
+  std::byte* buffers_[2] = { nullptr, nullptr };
+  size_t filling_ = 0;      // buffer being filled in the background
+  std::future<chunk> pending_;
+};
+
+#endif  // SOA_IO_H
@@ -0,0 +1,162 @@
+/*
+ * Validity bitmaps and masked kernels over the columns of a SoA.
+ *
+ * A validity bitmap is a flag column, like the NAME_valid columns declared by SoA_nullable_column(): each 64-bit word
+ * holds the flags of 64 consecutive elements. The bitmap operations work one word at a time, and the masked kernels
+ * skip the words with no valid elements, and blend away the invalid lanes of the others instead of branching on them.
+ */
+
+#ifndef SOA_MASK_H
+#define SOA_MASK_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "soa_simd.h"
+#include "soa_v4.h"
+
+// read-write and read-only validity bitmaps, as returned by the accessors of a flag column
+using soa_mask = soa_packed_column<soa_flag>;
+using soa_const_mask = soa_packed_column<soa_flag const>;
+
+namespace soa_detail {
+
+  inline uint64_t low_mask(size_t bits) {
+    return (bits >= 64) ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+  }
+
+  // number of 64-bit words spanned by `count` flags
+  inline size_t mask_words(size_t count) {
+    return (count + 63) / 64;
+  }
+
+  // the flags [64 * w, 64 * w + 64) of a bitmap with `count` flags, that may start in the middle of a word; the flags
+  // beyond `count` read as zero
+  inline uint64_t load_mask_word(soa_const_mask mask, size_t count, size_t w) {
+    size_t remaining = count - 64 * w;
+    size_t bit = mask.first() + 64 * w;
+    uint64_t const* words = mask.words() + bit / 64;
+    unsigned shift = bit % 64;
+    uint64_t value = words[0] >> shift;
+    if (shift and remaining > 64 - shift)
+      value |= words[1] << (64 - shift);
+    return value & low_mask(remaining);
+  }
+
+  // overwrite the flags [64 * w, 64 * w + 64) of a bitmap with `count` flags, leaving the flags beyond `count` untouched
+  inline void store_mask_word(soa_mask mask, size_t count, size_t w, uint64_t value) {
+    size_t remaining = count - 64 * w;
+    size_t bit = mask.first() + 64 * w;
+    uint64_t* words = mask.words() + bit / 64;
+    unsigned shift = bit % 64;
+    uint64_t bits = low_mask(remaining);
+    value &= bits;
+    words[0] = (words[0] & ~(bits << shift)) | (value << shift);
+    if (shift and remaining > 64 - shift)
+      words[1] = (words[1] & ~(bits >> (64 - shift))) | (value >> (64 - shift));
+  }
+
+  // signed integer with the same size as T, used for the lanes of the masks of a batch of T
+  template <size_t SIZE> struct lane_integer;
+  template <> struct lane_integer<1> { using type = int8_t; };
+  template <> struct lane_integer<2> { using type = int16_t; };
+  template <> struct lane_integer<4> { using type = int32_t; };
+  template <> struct lane_integer<8> { using type = int64_t; };
+
+}  // namespace soa_detail
+
+// number of valid elements among the first `count`
+inline size_t soa_mask_count(soa_const_mask mask, size_t count) {
+  size_t result = 0;
+  for (size_t w = 0; w < soa_detail::mask_words(count); ++w)
+    result += __builtin_popcountll(soa_detail::load_mask_word(mask, count, w));
+  return result;
+}
+
+// out = a & b, for the first `count` elements; `out` can be the same bitmap as `a` or `b`
+inline void soa_mask_and(soa_mask out, soa_const_mask a, soa_const_mask b, size_t count) {
+  for (size_t w = 0; w < soa_detail::mask_words(count); ++w)
+    soa_detail::store_mask_word(out, count, w, soa_detail::load_mask_word(a, count, w) & soa_detail::load_mask_word(b, count, w));
+}
+
+// out = a | b, for the first `count` elements; `out` can be the same bitmap as `a` or `b`
+inline void soa_mask_or(soa_mask out, soa_const_mask a, soa_const_mask b, size_t count) {
+  for (size_t w = 0; w < soa_detail::mask_words(count); ++w)
+    soa_detail::store_mask_word(out, count, w, soa_detail::load_mask_word(a, count, w) | soa_detail::load_mask_word(b, count, w));
+}
+
+// out = ~a, for the first `count` elements; `out` can be the same bitmap as `a`
+inline void soa_mask_not(soa_mask out, soa_const_mask a, size_t count) {
+  for (size_t w = 0; w < soa_detail::mask_words(count); ++w)
+    soa_detail::store_mask_word(out, count, w, ~soa_detail::load_mask_word(a, count, w));
+}
+
+// set the first `count` flags to `value`
+inline void soa_mask_fill(soa_mask out, bool value, size_t count) {
+  for (size_t w = 0; w < soa_detail::mask_words(count); ++w)
+    soa_detail::store_mask_word(out, count, w, value ? ~uint64_t(0) : 0);
+}
+
+// out[i] = predicate(values[i]) for the first `count` elements, 64 elements at a time without branching on the result
+template <typename T, typename PREDICATE>
+void soa_mask_from(soa_mask out, T const* values, size_t count, PREDICATE&& predicate) {
+  for (size_t w = 0; w < soa_detail::mask_words(count); ++w) {
+    size_t n = std::min<size_t>(64, count - 64 * w);
+    uint64_t word = 0;
+    for (size_t i = 0; i < n; ++i)
+      word |= static_cast<uint64_t>(static_cast<bool>(predicate(values[64 * w + i]))) << i;
+    soa_detail::store_mask_word(out, count, w, word);
+  }
+}
+
+// call f(i) for the valid elements among the first `count`, in increasing order, skipping 64 invalid elements at a time
+template <typename F>
+void soa_mask_for_each(soa_const_mask mask, size_t count, F&& f) {
+  for (size_t w = 0; w < soa_detail::mask_words(count); ++w)
+    for (uint64_t word = soa_detail::load_mask_word(mask, count, w); word; word &= word - 1)
+      f(64 * w + __builtin_ctzll(word));
+}
+
+// write the indices of the valid elements among the first `count` to `indices`, and return their number
+inline size_t soa_mask_indices(soa_const_mask mask, size_t count, size_t* indices) {
+  size_t size = 0;
+  soa_mask_for_each(mask, count, [&](size_t i) { indices[size++] = i; });
+  return size;
+}
+
+// sum of the valid elements among the first `count`, one batch at a time: the invalid lanes are zeroed with a bitwise
+// and, and the words without any valid element are skipped
+template <typename T>
+T soa_masked_sum(T const* values, soa_const_mask mask, size_t count) {
+  using batch_type = soa_batch<T>;
+  constexpr size_t W = batch_type::size;
+  static_assert(64 % W == 0, "the batch width must divide 64");
+  using lane_type = typename soa_detail::lane_integer<sizeof(T)>::type;
+  typedef lane_type lanes_type __attribute__((vector_size(sizeof(typename batch_type::vector_type))));
+
+  batch_type sum = batch_type::broadcast(T(0));
+  for (size_t w = 0; w < soa_detail::mask_words(count); ++w) {
+    uint64_t word = soa_detail::load_mask_word(mask, count, w);
+    if (word == 0)
+      continue;
+    size_t n = std::min<size_t>(64, count - 64 * w);
+    for (size_t i = 0; i < n; i += W) {
+      batch_type batch = batch_type::load(values + 64 * w + i, std::min(W, n - i));
+      // all bits set in the valid lanes, and zero in the invalid ones
+      lanes_type lanes;
+      for (size_t k = 0; k < W; ++k)
+        lanes[k] = -static_cast<lane_type>((word >> (i + k)) & 1);
+      batch.value = reinterpret_cast<typename batch_type::vector_type>(reinterpret_cast<lanes_type>(batch.value) & lanes);
+      sum += batch;
+    }
+  }
+
+  T result = 0;
+  for (size_t i = 0; i < W; ++i)
+    result += sum[i];
+  return result;
+}
+
+#endif  // SOA_MASK_H
@@ -0,0 +1,212 @@
+/*
+ * Memory management for the SoA buffers:
+ *   - an arena for the buffers of short-lived SoAs: the buffers of many SoAs are carved out of a few large slabs with a
+ *     bump pointer, and are all released at once, in constant time, by rewinding the arena;
+ *   - an allocator for large SoAs, backed by (transparent) huge pages and placed on the given NUMA nodes.
+ */
+
+#ifndef SOA_MEMORY_H
+#define SOA_MEMORY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// bump allocator over a list of slabs, released all at once by reset()
+class soa_arena {
+public:
+  // alignment of the slabs, and the largest alignment that can be requested
+  static constexpr size_t slab_alignment = 4096;
+
+  explicit soa_arena(size_t slab_size = 1 << 22) :
+    slab_size_(slab_size)
+  {}
+
+  ~soa_arena() {
+    release();
+  }
+
+  soa_arena(soa_arena const&) = delete;
+  soa_arena& operator=(soa_arena const&) = delete;
+
+  // return `bytes` bytes aligned to `alignment`, valid until the next call to reset()
+  std::byte* allocate(size_t bytes, size_t alignment) {
+    assert(alignment > 0 and alignment <= slab_alignment and (alignment & (alignment - 1)) == 0);
+    while (current_ < slabs_.size()) {
+      size_t offset = (offset_ + alignment - 1) & ~(alignment - 1);
+      if (offset + bytes <= slabs_[current_].size) {
+        offset_ = offset + bytes;
+        return slabs_[current_].data + offset;
+      }
+      // move on to the next slab, leaving the rest of this one unused until the next reset()
+      ++current_;
+      offset_ = 0;
+    }
+    // allocate a new slab, large enough for this request; the slabs are page aligned, so no padding is needed
+    size_t size = std::max(slab_size_, (bytes + slab_alignment - 1) / slab_alignment * slab_alignment);
+    slabs_.push_back(slab{ static_cast<std::byte*>(::operator new(size, std::align_val_t(slab_alignment))), size });
+    current_ = slabs_.size() - 1;
+    offset_ = bytes;
+    return slabs_[current_].data;
+  }
+
+  // the memory is only released by reset()
+  void deallocate(std::byte*, size_t, size_t) {}
+
+  // release all the memory handed out so far, keeping the slabs for reuse
+  void reset() {
+    current_ = 0;
+    offset_ = 0;
+  }
+
+  // release the slabs back to the system
+  void release() {
+    for (auto const& slab: slabs_)
+      ::operator delete(slab.data, slab.size, std::align_val_t(slab_alignment));
+    slabs_.clear();
+    reset();
+  }
+
+  // total size of the slabs
+  size_t capacity() const {
+    size_t size = 0;
+    for (auto const& slab: slabs_)
+      size += slab.size;
+    return size;
+  }
+
+  // number of slabs
+  size_t slabs() const { return slabs_.size(); }
+
+  // a runtime sized SoA, like SoALayout<ALIGN> or SoATiled<TILE, ALIGN>, with its buffer in the arena
+  template <typename LAYOUT>
+  LAYOUT make(size_t elements) {
+    return LAYOUT(allocate(LAYOUT::compute_data_size(elements), LAYOUT::buffer_alignment), elements);
+  }
+
+  // a compile-time sized SoA, like SoA<SIZE, ALIGN>, constructed in the arena; it is never destroyed
+  template <typename SOA>
+  SOA& create() {
+    static_assert(std::is_trivially_destructible_v<SOA>, "only trivially destructible types can be created in an arena");
+    return *new (allocate(sizeof(SOA), alignof(SOA))) SOA;
+  }
+
+  // an arena private to the calling thread, to avoid any contention between threads
+  static soa_arena& thread_instance() {
+    thread_local soa_arena arena;
+    return arena;
+  }
+
+private:
+  struct slab {
+    std::byte* data;
+    size_t size;
+  };
+
+  size_t slab_size_;
+  std::vector<slab> slabs_;
+  size_t current_ = 0;      // slab used by the next allocation
+  size_t offset_ = 0;       // first free byte in the current slab
+};
+
+// allocator policy for the growable SoAs, like SoAVector<ALIGN, soa_arena_allocator>, taking their buffers from an arena;
+// the buffers left behind when a SoA grows are only reclaimed when the arena is reset
+class soa_arena_allocator {
+public:
+  soa_arena_allocator(soa_arena& arena = soa_arena::thread_instance()) :
+    arena_(&arena)
+  {}
+
+  std::byte* allocate(size_t bytes, size_t alignment) { return arena_->allocate(bytes, alignment); }
+
+  void deallocate(std::byte* buffer, size_t bytes, size_t alignment) { arena_->deallocate(buffer, bytes, alignment); }
+
+private:
+  soa_arena* arena_;
+};
+
+// pages backing the buffers allocated by soa_page_allocator
+enum class soa_page_policy {
+  normal,               // regular pages
+  transparent_huge,     // regular pages, with a hint to the kernel to back them with transparent huge pages
+  huge                  // huge pages from the preallocated pool (MAP_HUGETLB), or transparent huge pages if none is available
+};
+
+// placement of the pages across the NUMA nodes
+enum class soa_numa_policy {
+  first_touch,          // each page is placed on the node of the thread that first writes to it, see soa_first_touch()
+  bind,                 // the pages are placed only on the given nodes
+  interleave            // the pages are interleaved across the given nodes
+};
+
+// allocator policy for the growable SoAs, like SoAVector<ALIGN, soa_page_allocator<...>>, mapping the buffers directly
+// from the kernel with the given page and NUMA policies; the NUMA placement is a hint, and is silently ignored on systems
+// without NUMA support
+template <soa_page_policy PAGES = soa_page_policy::transparent_huge, soa_numa_policy NUMA = soa_numa_policy::first_touch>
+class soa_page_allocator {
+public:
+  static constexpr size_t huge_page_size = 2 << 20;
+
+  // `nodes` is the bit mask of the NUMA nodes used by the bind and interleave policies
+  explicit soa_page_allocator(unsigned long nodes = ~0ul) :
+    nodes_(nodes)
+  {}
+
+  std::byte* allocate(size_t bytes, size_t alignment) {
+    size_t size = mapped_size(bytes);
+    assert(alignment <= page_size());
+    void* buffer = MAP_FAILED;
+    if constexpr (PAGES == soa_page_policy::huge)
+      buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (buffer == MAP_FAILED) {
+      if constexpr (PAGES == soa_page_policy::normal) {
+        buffer = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      } else {
+        // over-allocate and trim the mapping, so that it starts and ends on a huge page boundary
+        std::byte* mapping = static_cast<std::byte*>(mmap(nullptr, size + huge_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (mapping == MAP_FAILED)
+          throw std::bad_alloc();
+        std::byte* aligned = reinterpret_cast<std::byte*>((reinterpret_cast<uintptr_t>(mapping) + huge_page_size - 1) & ~(huge_page_size - 1));
+        if (aligned > mapping)
+          munmap(mapping, aligned - mapping);
+        if (aligned + size < mapping + size + huge_page_size)
+          munmap(aligned + size, mapping + size + huge_page_size - (aligned + size));
+        madvise(aligned, size, MADV_HUGEPAGE);
+        buffer = aligned;
+      }
+    }
+    if (buffer == MAP_FAILED)
+      throw std::bad_alloc();
+    if constexpr (NUMA == soa_numa_policy::bind)
+      syscall(SYS_mbind, buffer, size, MPOL_BIND, &nodes_, sizeof(nodes_) * 8, 0);
+    if constexpr (NUMA == soa_numa_policy::interleave)
+      syscall(SYS_mbind, buffer, size, MPOL_INTERLEAVE, &nodes_, sizeof(nodes_) * 8, 0);
+    return static_cast<std::byte*>(buffer);
+  }
+
+  void deallocate(std::byte* buffer, size_t bytes, size_t) {
+    munmap(buffer, mapped_size(bytes));
+  }
+
+private:
+  static size_t page_size() {
+    return (PAGES == soa_page_policy::normal) ? static_cast<size_t>(sysconf(_SC_PAGESIZE)) : huge_page_size;
+  }
+
+  static size_t mapped_size(size_t bytes) {
+    return (bytes + page_size() - 1) / page_size() * page_size();
+  }
+
+  unsigned long nodes_;
+};
+
+#endif  // SOA_MEMORY_H
@@ -0,0 +1,381 @@
+/*
+ * Parallel execution over the elements of a SoA: the elements are split in chunks aligned to the
+ * cache lines of all the columns, and the chunks are executed by a work-stealing thread pool.
+ */
+
+#ifndef SOA_PARALLEL_H
+#define SOA_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// size of a cache line, used to align the chunk boundaries
+constexpr size_t soa_cache_line_size = 64;
+
+// thread pool where each worker has its own queue of tasks, and steals tasks from the other queues when it runs out
+class soa_thread_pool {
+public:
+  explicit soa_thread_pool(unsigned threads = std::max(1u, std::thread::hardware_concurrency())) :
+    queues_(threads + 1)
+  {
+    // the last queue is used by the threads calling parallel_for()
+    for (auto& queue: queues_)
+      queue = std::make_unique<task_queue>();
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i)
+      workers_.emplace_back([this, i] { work(i); });
+  }
+
+  ~soa_thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker: workers_)
+      worker.join();
+  }
+
+  soa_thread_pool(soa_thread_pool const&) = delete;
+  soa_thread_pool& operator=(soa_thread_pool const&) = delete;
+
+  // number of worker threads
+  unsigned size() const { return workers_.size(); }
+
+  // call f(i) for each i in [0, tasks), and wait for all the calls to complete; the calling thread takes part in the work;
+  // if any call throws, the first exception is rethrown after all the calls have completed
+  template <typename F>
+  void parallel_for(size_t tasks, F&& f) {
+    if (tasks == 0)
+      return;
+    // state shared with the tasks, which must outlive all of them
+    struct {
+      std::mutex mutex;
+      std::condition_variable done;
+      size_t remaining;
+      std::exception_ptr error;
+    } state;
+    state.remaining = tasks;
+    for (size_t i = 0; i < tasks; ++i) {
+      push(i % queues_.size(), [&f, &state, i] {
+        std::exception_ptr error;
+        try {
+          f(i);
+        } catch (...) {
+          error = std::current_exception();
+        }
+        // notify while holding the lock, so that parallel_for() cannot return before the notification is complete
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (error and not state.error)
+          state.error = error;
+        if (--state.remaining == 0)
+          state.done.notify_all();
+      });
+    }
+    // help with the work while there are tasks in the queues, then wait for the ones still running on the workers
+    while (run_one(queues_.size() - 1)) {
+    }
+    {
+      std::unique_lock<std::mutex> lock(state.mutex);
+      state.done.wait(lock, [&state] { return state.remaining == 0; });
+    }
+    if (state.error)
+      std::rethrow_exception(state.error);
+  }
+
+  // pool shared by the whole application
+  static soa_thread_pool& instance() {
+    static soa_thread_pool pool;
+    return pool;
+  }
+
+private:
+  using task = std::function<void()>;
+
+  struct task_queue {
+    std::mutex mutex;
+    std::deque<task> tasks;
+  };
+
+  void push(size_t queue, task t) {
+    // count the task before queueing it, so that the count never underflows
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++pending_;
+    }
+    {
+      std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+      queues_[queue]->tasks.push_back(std::move(t));
+    }
+    wake_.notify_one();
+  }
+
+  // take a task from the back of the given queue, or steal one from the front of an other queue
+  bool pop(size_t queue, task& t) {
+    for (size_t i = 0; i < queues_.size(); ++i) {
+      size_t index = (queue + i) % queues_.size();
+      std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+      auto& tasks = queues_[index]->tasks;
+      if (tasks.empty())
+        continue;
+      if (i == 0) {
+        t = std::move(tasks.back());
+        tasks.pop_back();
+      } else {
+        t = std::move(tasks.front());
+        tasks.pop_front();
+      }
+      std::lock_guard<std::mutex> global(mutex_);
+      --pending_;
+      return true;
+    }
+    return false;
+  }
+
+  bool run_one(size_t queue) {
+    task t;
+    if (not pop(queue, t))
+      return false;
+    t();
+    return true;
+  }
+
+  void work(size_t queue) {
+    while (true) {
+      if (run_one(queue))
+        continue;
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this] { return stop_ or pending_ > 0; });
+      if (stop_ and pending_ == 0)
+        return;
+    }
+  }
+
+  std::vector<std::unique_ptr<task_queue>> queues_;
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  size_t pending_ = 0;
+  bool stop_ = false;
+};
+
+
+namespace soa_detail {
+
+  // smallest number of elements that spans a whole number of cache lines in every column of the SoA type VIEW; for the
+  // bit-packed columns this also keeps the threads from writing to the same 64-bit words
+  template <typename VIEW>
+  constexpr
+  size_t chunk_granularity() {
+    size_t granularity = 1;
+    for (auto const& field: VIEW::fields)
+      if (field.bits)
+        granularity = std::lcm(granularity, soa_cache_line_size * 8 / std::gcd(soa_cache_line_size * 8, field.bits));
+      else if (field.is_column)
+        granularity = std::lcm(granularity, soa_cache_line_size / std::gcd(soa_cache_line_size, field.size));
+    return granularity;
+  }
+
+  // number of elements in each chunk: a multiple of the granularity, aiming for a few chunks per thread
+  template <typename VIEW>
+  size_t chunk_size(size_t size, soa_thread_pool const& pool) {
+    constexpr size_t granularity = chunk_granularity<VIEW>();
+    size_t chunks = 4 * (pool.size() + 1);
+    size_t elements = (size + chunks - 1) / chunks;
+    return std::max(granularity, (elements + granularity - 1) / granularity * granularity);
+  }
+
+}  // namespace soa_detail
+
+
+// call f(first, count) on the consecutive chunks of [0, size), in parallel; the chunk boundaries fall on cache line
+// boundaries in all the columns of the SoA type VIEW, as long as the columns are aligned to the cache line size
+template <typename VIEW, typename F>
+void soa_parallel_for(soa_thread_pool& pool, size_t size, F&& f) {
+  size_t chunk = soa_detail::chunk_size<VIEW>(size, pool);
+  pool.parallel_for((size + chunk - 1) / chunk, [&](size_t c) {
+    size_t first = c * chunk;
+    f(first, std::min(chunk, size - first));
+  });
+}
+
+// call f(view) on the views over consecutive chunks of the elements of `soa`, in parallel
+template <typename SOA, typename F>
+void soa_for_each_chunk(soa_thread_pool& pool, SOA&& soa, F&& f) {
+  auto view = soa.view();
+  soa_parallel_for<decltype(view)>(pool, view.size(), [&](size_t first, size_t count) {
+    f(view.subspan(first, count));
+  });
+}
+
+template <typename SOA, typename F>
+void soa_for_each_chunk(SOA&& soa, F&& f) {
+  soa_for_each_chunk(soa_thread_pool::instance(), std::forward<SOA>(soa), std::forward<F>(f));
+}
+
+// call f(element) on all the elements of `soa`, in parallel
+template <typename SOA, typename F>
+void soa_for_each(soa_thread_pool& pool, SOA&& soa, F&& f) {
+  soa_for_each_chunk(pool, std::forward<SOA>(soa), [&f](auto const& chunk) {
+    for (size_t i = 0; i < chunk.size(); ++i)
+      f(chunk[i]);
+  });
+}
+
+template <typename SOA, typename F>
+void soa_for_each(SOA&& soa, F&& f) {
+  soa_for_each(soa_thread_pool::instance(), std::forward<SOA>(soa), std::forward<F>(f));
+}
+
+// call f(in, out) on the corresponding elements of `source` and `destination`, in parallel; the chunks are aligned to
+// the cache lines of the destination, so that no two threads write to the same cache line
+template <typename SOURCE, typename DESTINATION, typename F>
+void soa_transform(soa_thread_pool& pool, SOURCE const& source, DESTINATION&& destination, F&& f) {
+  auto input = source.view();
+  auto output = destination.view();
+  assert(input.size() == output.size());
+  soa_parallel_for<decltype(output)>(pool, output.size(), [&](size_t first, size_t count) {
+    auto in = input.subspan(first, count);
+    auto out = output.subspan(first, count);
+    for (size_t i = 0; i < count; ++i)
+      f(in[i], out[i]);
+  });
+}
+
+template <typename SOURCE, typename DESTINATION, typename F>
+void soa_transform(SOURCE const& source, DESTINATION&& destination, F&& f) {
+  soa_transform(soa_thread_pool::instance(), source, std::forward<DESTINATION>(destination), std::forward<F>(f));
+}
+
+// combine the results of transform(element) for all the elements of `soa` with reduce(), starting from `init`, in
+// parallel; the partial results of the chunks are combined in order, so the result does not depend on the scheduling
+template <typename SOA, typename T, typename REDUCE, typename TRANSFORM>
+T soa_reduce(soa_thread_pool& pool, SOA const& soa, T init, REDUCE&& reduce, TRANSFORM&& transform) {
+  auto view = soa.view();
+  using view_type = decltype(view);
+  size_t size = view.size();
+  size_t chunk = soa_detail::chunk_size<view_type>(size, pool);
+  std::vector<T> partial((size + chunk - 1) / chunk);
+  pool.parallel_for(partial.size(), [&](size_t c) {
+    size_t first = c * chunk;
+    auto part = view.subspan(first, std::min(chunk, size - first));
+    T result = transform(part[0]);
+    for (size_t i = 1; i < part.size(); ++i)
+      result = reduce(std::move(result), transform(part[i]));
+    partial[c] = std::move(result);
+  });
+  for (auto& result: partial)
+    init = reduce(std::move(init), std::move(result));
+  return init;
+}
+
+template <typename SOA, typename T, typename REDUCE, typename TRANSFORM>
+T soa_reduce(SOA const& soa, T init, REDUCE&& reduce, TRANSFORM&& transform) {
+  return soa_reduce(soa_thread_pool::instance(), soa, std::move(init), std::forward<REDUCE>(reduce), std::forward<TRANSFORM>(transform));
+}
+
+// write zeros to all the columns of `soa`, in parallel: with a first touch NUMA policy, like soa_page_allocator<...,
+// soa_numa_policy::first_touch>, the pages of each chunk are placed on the node of the worker that touches them first
+template <typename SOA>
+void soa_first_touch(soa_thread_pool& pool, SOA&& soa) {
+  soa_for_each_chunk(pool, soa, [](auto chunk) {
+    std::apply([&](auto... columns) {
+      auto zero = [&](auto column) {
+        auto [data, bytes] = soa_detail::column_storage(column, chunk.size());
+        std::memset(data, 0, bytes);
+      };
+      (zero(columns), ...);
+    }, chunk.columns());
+  });
+}
+
+template <typename SOA>
+void soa_first_touch(SOA&& soa) {
+  soa_first_touch(soa_thread_pool::instance(), std::forward<SOA>(soa));
+}
+
+// concurrent append into the preallocated elements of a view: each producer reserves a batch of consecutive elements
+// with a single atomic operation, and fills them without further synchronisation; the elements appended by the
+// producers are visible to the other threads once the producers have been joined, e.g. at the end of parallel_for()
+template <typename VIEW>
+class soa_appender {
+  static_assert(not soa_detail::has_packed_fields(VIEW::fields), "concurrent appends would race on the words of the bit-packed columns");
+
+public:
+  using view_type = VIEW;
+  using value_type = typename VIEW::value_type;
+
+  explicit soa_appender(VIEW view) :
+    view_(view),
+    size_(0)
+  {}
+
+  soa_appender(soa_appender const&) = delete;
+  soa_appender& operator=(soa_appender const&) = delete;
+
+  // reserve `count` consecutive elements, and return a view over them; if the view is full the returned view is shorter
+  // than requested, possibly empty, and overflow() becomes true
+  VIEW reserve(size_t count) {
+    size_t first = size_.fetch_add(count, std::memory_order_relaxed);
+    size_t capacity = view_.size();
+    if (first >= capacity)
+      return view_.subspan(capacity, 0);
+    return view_.subspan(first, std::min(count, capacity - first));
+  }
+
+  // append a single element; return false if the view is full
+  bool push_back(value_type const& value) {
+    VIEW slot = reserve(1);
+    if (slot.size() == 0)
+      return false;
+    slot[0] = value;
+    return true;
+  }
+
+  // number of elements that can be appended
+  size_t capacity() const { return view_.size(); }
+
+  // number of elements appended so far
+  size_t size() const { return std::min(requested(), capacity()); }
+
+  // number of elements requested so far, including the ones that did not fit
+  size_t requested() const { return size_.load(std::memory_order_relaxed); }
+
+  // true if some of the requested elements did not fit
+  bool overflow() const { return requested() > capacity(); }
+
+  // view over the elements appended so far
+  VIEW view() const { return view_.subspan(0, size()); }
+
+  // forget the elements appended so far; must not be called concurrently with reserve() or push_back()
+  void clear() { size_.store(0, std::memory_order_relaxed); }
+
+private:
+  VIEW view_;
+
+  // the counter is modified by all the producers, keep it on its own cache line
+  alignas(soa_cache_line_size) std::atomic<size_t> size_;
+};
+
+// concurrent appender over the elements of `soa`
+template <typename SOA>
+auto soa_make_appender(SOA&& soa) {
+  return soa_appender<decltype(soa.view())>(soa.view());
+}
+
+#endif  // SOA_PARALLEL_H
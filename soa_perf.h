@@ -0,0 +1,208 @@
+/*
+ * Optional hardware performance counters around the regions of code that operate on a SoA.
+ *
+ * The counters are read with the Linux perf_event_open(2) interface, accumulated per named region, and reported in
+ * absolute terms and per byte of column data. Unless SOA_PERF is defined, SOA_PERF_REGION() expands to nothing.
+ */
+
+#ifndef SOA_PERF_H
+#define SOA_PERF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+// total number of bytes in the columns of a view, as described by its fields
+template <typename VIEW>
+size_t soa_column_bytes(VIEW const& view) {
+  size_t bytes = 0;
+  for (auto const& field: VIEW::fields)
+    if (field.bits)
+      bytes += (field.bits * view.size() + 7) / 8;
+    else if (field.is_column)
+      bytes += field.size * view.size();
+  return bytes;
+}
+
+#ifdef SOA_PERF
+
+#include <array>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// hardware events measured in each region
+enum class soa_perf_event { cycles, instructions, l1d_misses, llc_misses, dtlb_misses, size };
+
+namespace soa_detail {
+
+  constexpr size_t perf_events = static_cast<size_t>(soa_perf_event::size);
+
+  constexpr const char* perf_event_names[perf_events] = { "cycles", "instructions", "L1d misses", "LLC misses", "dTLB misses" };
+
+  constexpr uint64_t perf_cache_event(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+  }
+
+  // one counter per event, for the calling thread; the events that are not available are left closed
+  class perf_counters {
+  public:
+    perf_counters() {
+      constexpr std::pair<uint32_t, uint64_t> events[perf_events] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, perf_cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HW_CACHE, perf_cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+      };
+      for (size_t i = 0; i < perf_events; ++i) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = events[i].first;
+        attr.config = events[i].second;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fds_[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      }
+    }
+
+    ~perf_counters() {
+      for (int fd: fds_)
+        if (fd >= 0)
+          close(fd);
+    }
+
+    perf_counters(perf_counters const&) = delete;
+    perf_counters& operator=(perf_counters const&) = delete;
+
+    // counters of the calling thread
+    static perf_counters& instance() {
+      thread_local perf_counters counters;
+      return counters;
+    }
+
+    bool available(size_t event) const { return fds_[event] >= 0; }
+
+    // current value of all the counters; the unavailable ones read as zero
+    std::array<uint64_t, perf_events> read() const {
+      std::array<uint64_t, perf_events> values{};
+      for (size_t i = 0; i < perf_events; ++i)
+        if (fds_[i] < 0 or ::read(fds_[i], &values[i], sizeof(uint64_t)) != sizeof(uint64_t))
+          values[i] = 0;
+      return values;
+    }
+
+  private:
+    int fds_[perf_events];
+  };
+
+}  // namespace soa_detail
+
+// counters accumulated over all the executions of the regions with the same name
+struct soa_perf_stats {
+  size_t calls = 0;
+  size_t bytes = 0;
+  std::array<uint64_t, soa_detail::perf_events> counters{};
+  std::array<bool, soa_detail::perf_events> available{};
+};
+
+// registry of the counters of all the regions, from all the threads
+class soa_perf_registry {
+public:
+  static soa_perf_registry& instance() {
+    static soa_perf_registry registry;
+    return registry;
+  }
+
+  void add(std::string const& name, size_t bytes, std::array<uint64_t, soa_detail::perf_events> const& counters,
+           std::array<bool, soa_detail::perf_events> const& available) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& stats = regions_[name];
+    stats.calls += 1;
+    stats.bytes += bytes;
+    for (size_t i = 0; i < soa_detail::perf_events; ++i) {
+      stats.counters[i] += counters[i];
+      stats.available[i] = stats.available[i] or available[i];
+    }
+  }
+
+  std::map<std::string, soa_perf_stats> regions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return regions_;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    regions_.clear();
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::map<std::string, soa_perf_stats> regions_;
+};
+
+// measure the hardware counters from its construction to its destruction, and add them to the named region
+class soa_perf_region {
+public:
+  soa_perf_region(const char* name, size_t bytes) :
+    name_(name),
+    bytes_(bytes),
+    start_(soa_detail::perf_counters::instance().read())
+  {}
+
+  ~soa_perf_region() {
+    auto& counters = soa_detail::perf_counters::instance();
+    auto stop = counters.read();
+    std::array<bool, soa_detail::perf_events> available;
+    for (size_t i = 0; i < soa_detail::perf_events; ++i) {
+      stop[i] -= start_[i];
+      available[i] = counters.available(i);
+    }
+    soa_perf_registry::instance().add(name_, bytes_, stop, available);
+  }
+
+  soa_perf_region(soa_perf_region const&) = delete;
+  soa_perf_region& operator=(soa_perf_region const&) = delete;
+
+private:
+  const char* name_;
+  size_t bytes_;
+  std::array<uint64_t, soa_detail::perf_events> start_;
+};
+
+// print the counters of all the regions, in total and per byte of column data
+inline void soa_perf_report(std::ostream& out = std::cerr) {
+  for (auto const& [name, stats]: soa_perf_registry::instance().regions()) {
+    out << name << ": " << stats.calls << " calls, " << stats.bytes << " bytes\n";
+    for (size_t i = 0; i < soa_detail::perf_events; ++i) {
+      out << "  " << std::setw(14) << std::left << soa_detail::perf_event_names[i] << std::right;
+      if (stats.available[i])
+        out << std::setw(16) << stats.counters[i] << std::setw(12) << std::fixed << std::setprecision(4)
+            << (stats.bytes ? double(stats.counters[i]) / stats.bytes : 0.) << " per byte\n";
+      else
+        out << std::setw(16) << "n/a" << '\n';
+    }
+  }
+  out << std::flush;
+}
+
+#define _SOA_PERF_CAT_IMPL(A, B) A##B
+#define _SOA_PERF_CAT(A, B) _SOA_PERF_CAT_IMPL(A, B)
+
+// measure the rest of the enclosing scope as the region NAME, touching BYTES bytes of column data
+#define SOA_PERF_REGION(NAME, BYTES) soa_perf_region _SOA_PERF_CAT(soa_perf_region_, __LINE__)(NAME, BYTES)
+
+#else  // SOA_PERF
+
+inline void soa_perf_report(std::ostream& = std::cerr) {}
+
+#define SOA_PERF_REGION(NAME, BYTES)
+
+#endif  // SOA_PERF
+
+#endif  // SOA_PERF_H
@@ -0,0 +1,134 @@
+/*
+ * Explicit SIMD access to the columns of a SoA: load and store batches of consecutive elements of a
+ * column as a native vector, whose width is selected at compile time from the target architecture.
+ */
+
+#ifndef SOA_SIMD_H
+#define SOA_SIMD_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// width in bytes of the native SIMD registers
+#if defined(__AVX512F__)
+constexpr size_t soa_simd_width = 64;
+#elif defined(__AVX__)
+constexpr size_t soa_simd_width = 32;
+#else
+constexpr size_t soa_simd_width = 16;
+#endif
+
+// width in bytes of the native SIMD operations on elements of type T: AVX provides 256-bit operations only for floating
+// point types, integer types need AVX2; AVX-512F provides 512-bit integer operations only on 32 and 64-bit elements, the
+// narrower ones need AVX-512BW
+template <typename T>
+constexpr size_t soa_simd_width_of() {
+  if constexpr (std::is_floating_point_v<T>) {
+    return soa_simd_width;
+  } else {
+#if defined(__AVX512BW__)
+    return 64;
+#elif defined(__AVX512F__)
+    return (sizeof(T) >= 4) ? 64 : 32;
+#elif defined(__AVX2__)
+    return 32;
+#else
+    return 16;
+#endif
+  }
+}
+
+// batch of W consecutive elements of a column, held in a native vector
+template <typename T, size_t W = soa_simd_width_of<T>() / sizeof(T)>
+struct soa_batch {
+  static_assert(W > 0 and (W & (W - 1)) == 0, "the batch width must be a power of two");
+
+  static constexpr size_t size = W;
+  using value_type = T;
+  typedef T vector_type __attribute__((vector_size(W * sizeof(T))));
+
+  vector_type value;
+
+  // broadcast a single value to all the elements of the batch
+  static soa_batch broadcast(T x) {
+    soa_batch batch;
+    for (size_t i = 0; i < W; ++i)
+      batch.value[i] = x;
+    return batch;
+  }
+
+  // load W consecutive elements
+  static soa_batch load(T const* data) {
+    soa_batch batch;
+    std::memcpy(&batch.value, data, sizeof(vector_type));
+    return batch;
+  }
+
+  // load W consecutive elements from a column aligned to the vector size
+  static soa_batch load_aligned(T const* data) {
+    assert(reinterpret_cast<uintptr_t>(data) % sizeof(vector_type) == 0);
+    return soa_batch{ *reinterpret_cast<vector_type const*>(data) };
+  }
+
+  // load `count` <= W consecutive elements, setting the remaining ones to zero
+  static soa_batch load(T const* data, size_t count) {
+    if (count == W)
+      return load(data);
+    assert(count < W);
+    soa_batch batch{ vector_type{} };
+    std::memcpy(&batch.value, data, count * sizeof(T));
+    return batch;
+  }
+
+  // store W consecutive elements
+  void store(T* data) const {
+    std::memcpy(data, &value, sizeof(vector_type));
+  }
+
+  // store W consecutive elements to a column aligned to the vector size
+  void store_aligned(T* data) const {
+    assert(reinterpret_cast<uintptr_t>(data) % sizeof(vector_type) == 0);
+    *reinterpret_cast<vector_type*>(data) = value;
+  }
+
+  // store the first `count` <= W elements
+  void store(T* data, size_t count) const {
+    if (count == W)
+      return store(data);
+    assert(count < W);
+    std::memcpy(data, &value, count * sizeof(T));
+  }
+
+  T operator[](size_t i) const { return value[i]; }
+
+  soa_batch& operator+=(soa_batch const& other) { value += other.value; return *this; }
+  soa_batch& operator-=(soa_batch const& other) { value -= other.value; return *this; }
+  soa_batch& operator*=(soa_batch const& other) { value *= other.value; return *this; }
+  soa_batch& operator/=(soa_batch const& other) { value /= other.value; return *this; }
+
+  friend soa_batch operator+(soa_batch a, soa_batch const& b) { return a += b; }
+  friend soa_batch operator-(soa_batch a, soa_batch const& b) { return a -= b; }
+  friend soa_batch operator*(soa_batch a, soa_batch const& b) { return a *= b; }
+  friend soa_batch operator/(soa_batch a, soa_batch const& b) { return a /= b; }
+
+  friend soa_batch operator+(soa_batch a, T b) { return a += broadcast(b); }
+  friend soa_batch operator-(soa_batch a, T b) { return a -= broadcast(b); }
+  friend soa_batch operator*(soa_batch a, T b) { return a *= broadcast(b); }
+  friend soa_batch operator/(soa_batch a, T b) { return a /= broadcast(b); }
+};
+
+// call f(index, count) for each batch of W consecutive elements in [0, size): count is W for all the
+// batches but the last one, which holds the remaining size % W elements, if any
+template <size_t W, typename F>
+void soa_for_each_batch(size_t size, F&& f) {
+  size_t index = 0;
+  for (; index + W <= size; index += W)
+    f(index, W);
+  if (index < size)
+    f(index, size - index);
+}
+
+#endif  // SOA_SIMD_H
@@ -0,0 +1,155 @@
+/*
+ * String columns, storing a small fixed-size handle per element instead of a pointer to a separately allocated string:
+ *   - SoA_string_column(NAME): the offset and size of each string inside a soa_string_buffer, that holds the characters
+ *     of all the strings in a single contiguous buffer;
+ *   - SoA_interned_column(NAME): a soa_string_id per element, identifying the string in a soa_dictionary that holds each
+ *     distinct string once, as an array of offsets into a single contiguous buffer; comparing two strings from the same
+ *     dictionary is an integer comparison.
+ *
+ * The buffer or dictionary is shared by all the elements of the column, or by many SoAs, and is owned by the caller.
+ */
+
+#ifndef SOA_STRING_H
+#define SOA_STRING_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "soa_mask.h"
+
+// position of a string inside a soa_string_buffer
+struct soa_string {
+  uint32_t offset;
+  uint32_t size;
+};
+
+// contiguous storage for the characters of the strings of one or more string columns
+class soa_string_buffer {
+public:
+  // append the characters of a string, and return its position
+  soa_string add(std::string_view value) {
+    assert(chars_.size() + value.size() <= std::numeric_limits<uint32_t>::max());
+    soa_string result{ static_cast<uint32_t>(chars_.size()), static_cast<uint32_t>(value.size()) };
+    chars_.insert(chars_.end(), value.begin(), value.end());
+    return result;
+  }
+
+  std::string_view operator[](soa_string value) const {
+    assert(value.offset + value.size <= chars_.size());
+    return std::string_view(chars_.data() + value.offset, value.size);
+  }
+
+  // total number of characters
+  size_t size() const { return chars_.size(); }
+
+  void reserve(size_t size) { chars_.reserve(size); }
+
+  // release all the strings; the positions returned so far become invalid
+  void clear() { chars_.clear(); }
+
+  char const* data() const { return chars_.data(); }
+
+private:
+  std::vector<char> chars_;
+};
+
+// identifier of a string inside a soa_dictionary
+struct soa_string_id {
+  uint32_t id;
+
+  friend bool operator==(soa_string_id a, soa_string_id b) { return a.id == b.id; }
+  friend bool operator!=(soa_string_id a, soa_string_id b) { return a.id != b.id; }
+};
+
+// intern table: each distinct string is stored once, and identified by a dense id, in the order the strings were added
+class soa_dictionary {
+public:
+  // identifier returned by find() for the strings that are not in the dictionary
+  static constexpr soa_string_id npos = { std::numeric_limits<uint32_t>::max() };
+
+  soa_dictionary() :
+    offsets_{ 0 },
+    slots_(16, npos.id)
+  { }
+
+  // identifier of a string, adding it to the dictionary if needed
+  soa_string_id intern(std::string_view value) {
+    size_t slot = lookup(value);
+    if (slots_[slot] != npos.id)
+      return soa_string_id{ slots_[slot] };
+
+    uint32_t id = static_cast<uint32_t>(size());
+    assert(id != npos.id);
+    chars_.insert(chars_.end(), value.begin(), value.end());
+    offsets_.push_back(static_cast<uint32_t>(chars_.size()));
+    slots_[slot] = id;
+    // keep the hash table at most half full
+    if (2 * size() > slots_.size())
+      rehash(2 * slots_.size());
+    return soa_string_id{ id };
+  }
+
+  // identifier of a string, or npos if the string is not in the dictionary
+  soa_string_id find(std::string_view value) const {
+    return soa_string_id{ slots_[lookup(value)] };
+  }
+
+  std::string_view operator[](soa_string_id value) const {
+    assert(value.id < size());
+    return std::string_view(chars_.data() + offsets_[value.id], offsets_[value.id + 1] - offsets_[value.id]);
+  }
+
+  // number of distinct strings
+  size_t size() const { return offsets_.size() - 1; }
+
+  // total number of characters
+  size_t characters() const { return chars_.size(); }
+
+private:
+  // slot holding the id of `value`, or the empty slot where it would be inserted
+  size_t lookup(std::string_view value) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t slot = std::hash<std::string_view>()(value) & mask;; slot = (slot + 1) & mask)
+      if (slots_[slot] == npos.id or (*this)[soa_string_id{ slots_[slot] }] == value)
+        return slot;
+  }
+
+  void rehash(size_t slots) {
+    slots_.assign(slots, npos.id);
+    for (uint32_t id = 0; id < size(); ++id)
+      slots_[lookup((*this)[soa_string_id{ id }])] = id;
+  }
+
+  std::vector<char> chars_;         // characters of all the strings, one after the other
+  std::vector<uint32_t> offsets_;   // the string `id` is chars_[offsets_[id], offsets_[id + 1])
+  std::vector<uint32_t> slots_;     // open addressing hash table of the ids, with linear probing
+};
+
+/* declare string columns, see above */
+
+#define SoA_string_column(NAME) (1, soa_string, NAME)
+#define SoA_interned_column(NAME) (1, soa_string_id, NAME)
+
+// out[i] = (column[i] == value) for the first `count` elements of an interned column: the string is looked up once,
+// and the elements are compared as integers
+inline void soa_string_match(soa_mask out, soa_string_id const* column, size_t count, soa_dictionary const& dictionary,
+                             std::string_view value) {
+  uint32_t id = dictionary.find(value).id;
+  soa_mask_from(out, column, count, [id](soa_string_id element) { return element.id == id; });
+}
+
+// out[i] = (column[i] == value) for the first `count` elements of a string column: the sizes are compared first, and
+// only the strings with the same size are compared character by character
+inline void soa_string_match(soa_mask out, soa_string const* column, size_t count, soa_string_buffer const& buffer,
+                             std::string_view value) {
+  soa_mask_from(out, column, count, [&](soa_string element) {
+    return element.size == value.size() and buffer[element] == value;
+  });
+}
+
+#endif  // SOA_STRING_H
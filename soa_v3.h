@@ -110,8 +110,8 @@ SOA_HOST_ONLY
 void dump() {                                                                                                                       \
   using SoA = T;                                                                                                                    \
   std::cout << #CLASS "<" << SoA::size << ", " << SoA::alignment << "): " << '\n';                                                  \
-  std::cout << "  sizeof(...): " << sizeof(CLASS) << '\n';                                                                          \
-  std::cout << "  alignof(...): " << alignof(CLASS) << '\n';                                                                        \
+  std::cout << "  sizeof(...): " << sizeof(SoA) << '\n';                                                                            \
+  std::cout << "  alignof(...): " << alignof(SoA) << '\n';                                                                          \
   _DECLARE_SOA_DUMP_INFOS(__VA_ARGS__)                                                                                              \
   std::cout << std::endl;                                                                                                           \
 }                                                                                                                                   \
@@ -1,12 +1,35 @@
 /*
  * Structure-of-Arrays template with "columns" and "scalars", defined through preprocessor macros,
  * with compile-time size and alignment, and accessors to the "rows" and "columns".
+ *
+ * The same declaration also generates a layout with a runtime size, that places all the columns
+ * and scalars inside a single caller-provided buffer, a tiled (AoSoA) layout that groups the columns
+ * of a fixed number of consecutive elements together, and non-owning views over (a range of) the
+ * elements of the compile-time and runtime sized SoA.
  */
 
+#ifndef SOA_V4_H
+#define SOA_V4_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 #include <boost/preprocessor.hpp>
 
+#if (defined(__F16C__) or defined(__AVX2__)) and not defined(__CUDACC__)
+#include <immintrin.h>
+#endif
+
 // CUDA attributes
 #ifdef __CUDACC__
 #define SOA_HOST_ONLY __host__
@@ -16,76 +39,867 @@
 #define SOA_HOST_DEVICE
 #endif
 
+// compile-time description of a SoA field ("column" or "scalar")
+struct soa_field_info {
+  const char* name;
+  size_t size;          // size of the type of each element, or 0 for the bit-packed columns
+  size_t alignment;     // natural alignment of the type
+  bool is_column;
+  size_t bits;          // number of bits of each element of a bit-packed column, or 0
+};
+
+// number of elements converted at a time between an array of structures and a SoA: a block of structures should stay in
+// the L1 cache while it is read or written one column at a time
+constexpr size_t soa_aos_block_size = 64;
+
+// reduced precision and bit-packed column types; a column is declared with one of these as its type, and its elements are
+// accessed through soa_column_traits below
+
+
+// storage of a half precision (IEEE 754 binary16) floating point value, converted to and from float on access
+struct soa_half {
+  uint16_t bits;
+
+  soa_half() = default;
+
+  SOA_HOST_DEVICE
+  soa_half(float value) : bits(from_float(value)) { }
+
+  SOA_HOST_DEVICE
+  operator float() const { return to_float(bits); }
+
+  // round to nearest even; values too large for a half become infinities, NaNs stay (quiet) NaNs
+  SOA_HOST_DEVICE
+  static uint16_t from_float(float value) {
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    x &= 0x7fffffff;
+    uint32_t result;
+    if (x >= 0x47800000) {
+      // 65536 or more, infinity, or NaN
+      result = (x > 0x7f800000) ? 0x7e00 : 0x7c00;
+    } else if (x < 0x38800000) {
+      // subnormal half or zero: let the floating point addition of 0.5 round the mantissa
+      float f;
+      std::memcpy(&f, &x, sizeof(x));
+      f += 0.5f;
+      std::memcpy(&x, &f, sizeof(x));
+      result = x - 0x3f000000;
+    } else {
+      // normal half: rebias the exponent and round the mantissa; a carry into the exponent is correct, and can overflow to
+      // infinity
+      x += 0xc8000fff + ((x >> 13) & 1);
+      result = x >> 13;
+    }
+    return static_cast<uint16_t>(result | sign);
+  }
+
+  SOA_HOST_DEVICE
+  static float to_float(uint16_t bits) {
+    uint32_t x = static_cast<uint32_t>(bits & 0x7fff) << 13;
+    uint32_t exponent = x & 0x0f800000;
+    x += 0x38000000;
+    if (exponent == 0x0f800000) {
+      // infinity or NaN
+      x += 0x38000000;
+    } else if (exponent == 0) {
+      // subnormal half or zero: renormalise through a floating point subtraction
+      x += 0x00800000;
+      float f;
+      std::memcpy(&f, &x, sizeof(x));
+      f -= 6.103515625e-05f;
+      std::memcpy(&x, &f, sizeof(x));
+    }
+    x |= static_cast<uint32_t>(bits & 0x8000) << 16;
+    float value;
+    std::memcpy(&value, &x, sizeof(x));
+    return value;
+  }
+};
+
+// storage of a bfloat16 floating point value (the upper half of a float), converted to and from float on access
+struct soa_bfloat16 {
+  uint16_t bits;
+
+  soa_bfloat16() = default;
+
+  SOA_HOST_DEVICE
+  soa_bfloat16(float value) : bits(from_float(value)) { }
+
+  SOA_HOST_DEVICE
+  operator float() const { return to_float(bits); }
+
+  // round to nearest even; NaNs stay (quiet) NaNs
+  SOA_HOST_DEVICE
+  static uint16_t from_float(float value) {
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    if ((x & 0x7fffffff) > 0x7f800000)
+      return static_cast<uint16_t>((x >> 16) | 0x0040);
+    return static_cast<uint16_t>((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+  }
+
+  SOA_HOST_DEVICE
+  static float to_float(uint16_t bits) {
+    uint32_t x = static_cast<uint32_t>(bits) << 16;
+    float value;
+    std::memcpy(&value, &x, sizeof(x));
+    return value;
+  }
+};
+
+// tag for a column of unsigned integers of BITS bits each, packed in 64-bit words and accessed as T
+template <size_t BITS, typename T = uint32_t>
+struct soa_packed {
+  static_assert(BITS > 0 and BITS < 64 and BITS <= sizeof(T) * 8, "unsupported number of bits");
+  static_assert(std::is_unsigned_v<T>, "the values of a packed column must be unsigned integers or bool");
+
+  static constexpr size_t bits = BITS;
+  static constexpr uint64_t mask = (uint64_t(1) << BITS) - 1;
+  using value_type = T;
+
+  // read the element `index` from the packed words
+  SOA_HOST_DEVICE
+  static T load(uint64_t const* words, size_t index) {
+    size_t bit = index * BITS;
+    size_t word = bit / 64;
+    unsigned shift = bit % 64;
+    uint64_t value = words[word] >> shift;
+    if (shift + BITS > 64)
+      value |= words[word + 1] << (64 - shift);
+    return static_cast<T>(value & mask);
+  }
+
+  // write the element `index` into the packed words; the neighbouring elements in the same words are read and written back,
+  // so concurrent writes to elements sharing a 64-bit word are not safe
+  SOA_HOST_DEVICE
+  static void store(uint64_t* words, size_t index, T value) {
+    size_t bit = index * BITS;
+    size_t word = bit / 64;
+    unsigned shift = bit % 64;
+    uint64_t bits = static_cast<uint64_t>(value) & mask;
+    words[word] = (words[word] & ~(mask << shift)) | (bits << shift);
+    if (shift + BITS > 64)
+      words[word + 1] = (words[word + 1] & ~(mask >> (64 - shift))) | (bits >> (64 - shift));
+  }
+};
+
+// tag for a column of boolean flags, one bit each
+using soa_flag = soa_packed<1, bool>;
+
+// proxy reference to an element of a packed column, returned by the element accessors
+template <typename PACKED>
+class soa_packed_reference {
+public:
+  using value_type = typename PACKED::value_type;
+
+  SOA_HOST_DEVICE
+  soa_packed_reference(uint64_t* words, size_t index) :
+    words_(words),
+    index_(index)
+  { }
+
+  SOA_HOST_DEVICE
+  operator value_type() const { return PACKED::load(words_, index_); }
+
+  SOA_HOST_DEVICE
+  soa_packed_reference& operator=(value_type value) {
+    PACKED::store(words_, index_, value);
+    return *this;
+  }
+
+  // assign the value, like a reference
+  SOA_HOST_DEVICE
+  soa_packed_reference& operator=(soa_packed_reference const& other) {
+    return *this = static_cast<value_type>(other);
+  }
+
+private:
+  uint64_t* words_;
+  size_t index_;
+};
+
+// pointer-like access to the elements of a packed column, starting from the element `first` of the 64-bit words `words`;
+// PACKED is soa_packed<...> or soa_packed<...> const
+template <typename PACKED>
+class soa_packed_column {
+public:
+  using packed_type = std::remove_const_t<PACKED>;
+  using value_type = typename packed_type::value_type;
+  using word_type = std::conditional_t<std::is_const_v<PACKED>, uint64_t const, uint64_t>;
+  using reference = std::conditional_t<std::is_const_v<PACKED>, value_type, soa_packed_reference<packed_type>>;
+
+  soa_packed_column() = default;
+
+  SOA_HOST_DEVICE
+  explicit soa_packed_column(word_type* words, size_t first = 0) :
+    words_(words),
+    first_(first)
+  { }
+
+  // conversion from a read-write to a read-only column
+  template <typename OTHER, typename = std::enable_if_t<std::is_same_v<OTHER const, PACKED> and not std::is_same_v<OTHER, PACKED>>>
+  SOA_HOST_DEVICE
+  soa_packed_column(soa_packed_column<OTHER> const& other) :
+    words_(other.words()),
+    first_(other.first())
+  { }
+
+  SOA_HOST_DEVICE
+  reference operator[](size_t index) const {
+    if constexpr (std::is_const_v<PACKED>)
+      return packed_type::load(words_, first_ + index);
+    else
+      return reference(words_, first_ + index);
+  }
+
+  SOA_HOST_DEVICE
+  soa_packed_column& operator+=(size_t offset) {
+    first_ += offset;
+    return *this;
+  }
+
+  SOA_HOST_DEVICE
+  soa_packed_column operator+(size_t offset) const { return soa_packed_column(words_, first_ + offset); }
+
+  SOA_HOST_DEVICE
+  word_type* words() const { return words_; }
+
+  SOA_HOST_DEVICE
+  size_t first() const { return first_; }
+
+private:
+  word_type* words_ = nullptr;
+  size_t first_ = 0;
+};
+
+// how the elements of a column of type T are stored and accessed:
+//   - storage_type: type of the data in memory;
+//   - value_type: type of the values, as in the element struct with value semantics;
+//   - pointer and reference: types returned by the column and element accessors;
+//   - size and bits: size in bytes of each element, or number of bits for the packed columns;
+//   - storage_count(n): number of storage_type objects holding n elements.
+template <typename T>
+struct soa_column_traits {
+  using storage_type = T;
+  using value_type = T;
+  using pointer = T*;
+  using reference = T&;
+  static constexpr size_t size = sizeof(T);
+  static constexpr size_t bits = 0;
+
+  SOA_HOST_DEVICE
+  static constexpr size_t storage_count(size_t elements) { return elements; }
+
+  SOA_HOST_DEVICE
+  static pointer make_pointer(storage_type* data) { return data; }
+};
+
+// the reduced precision columns are accessed as float
+template <>
+struct soa_column_traits<soa_half> : public soa_column_traits<soa_half const> {
+  using storage_type = soa_half;
+  using value_type = float;
+  using pointer = soa_half*;
+  using reference = soa_half&;
+
+  SOA_HOST_DEVICE
+  static pointer make_pointer(storage_type* data) { return data; }
+};
+
+template <>
+struct soa_column_traits<soa_bfloat16> : public soa_column_traits<soa_bfloat16 const> {
+  using storage_type = soa_bfloat16;
+  using value_type = float;
+  using pointer = soa_bfloat16*;
+  using reference = soa_bfloat16&;
+
+  SOA_HOST_DEVICE
+  static pointer make_pointer(storage_type* data) { return data; }
+};
+
+template <size_t BITS, typename T>
+struct soa_column_traits<soa_packed<BITS, T> const> {
+  using storage_type = uint64_t const;
+  using value_type = T;
+  using pointer = soa_packed_column<soa_packed<BITS, T> const>;
+  using reference = T;
+  static constexpr size_t size = 0;
+  static constexpr size_t bits = BITS;
+
+  SOA_HOST_DEVICE
+  static constexpr size_t storage_count(size_t elements) { return (elements * BITS + 63) / 64; }
+
+  SOA_HOST_DEVICE
+  static pointer make_pointer(storage_type* data) { return pointer(data); }
+};
+
+template <size_t BITS, typename T>
+struct soa_column_traits<soa_packed<BITS, T>> : public soa_column_traits<soa_packed<BITS, T> const> {
+  using storage_type = uint64_t;
+  using pointer = soa_packed_column<soa_packed<BITS, T>>;
+  using reference = soa_packed_reference<soa_packed<BITS, T>>;
+
+  SOA_HOST_DEVICE
+  static pointer make_pointer(storage_type* data) { return pointer(data); }
+};
+
+template <typename T>
+using soa_storage_t = typename soa_column_traits<T>::storage_type;
+
+template <typename T>
+using soa_value_t = typename soa_column_traits<T>::value_type;
+
+template <typename T>
+using soa_pointer_t = typename soa_column_traits<T>::pointer;
+
+template <typename T>
+using soa_reference_t = typename soa_column_traits<T>::reference;
+
+
+// bulk conversion between an array of values and the first `count` elements of a reduced precision or packed column, one
+// block of elements at a time, rather than one element at a time through the accessors
+
+inline void soa_pack(soa_half* column, float const* values, size_t count) {
+  size_t i = 0;
+#if defined(__F16C__) and not defined(__CUDACC__)
+  for (; i + 8 <= count; i += 8)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(column + i),
+                     _mm256_cvtps_ph(_mm256_loadu_ps(values + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+  for (; i < count; ++i)
+    column[i] = values[i];
+}
+
+inline void soa_unpack(float* values, soa_half const* column, size_t count) {
+  size_t i = 0;
+#if defined(__F16C__) and not defined(__CUDACC__)
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(values + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<__m128i const*>(column + i))));
+#endif
+  for (; i < count; ++i)
+    values[i] = column[i];
+}
+
+// the same rounding and NaN handling as soa_bfloat16::from_float(), on the integer representation of 8 values at a time
+inline void soa_pack(soa_bfloat16* column, float const* values, size_t count) {
+  size_t i = 0;
+#if defined(__AVX2__) and not defined(__CUDACC__)
+  for (; i + 8 <= count; i += 8) {
+    __m256i x = _mm256_castps_si256(_mm256_loadu_ps(values + i));
+    __m256i high = _mm256_srli_epi32(x, 16);
+    __m256i bias = _mm256_add_epi32(_mm256_set1_epi32(0x7fff), _mm256_and_si256(high, _mm256_set1_epi32(1)));
+    __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(x, bias), 16);
+    __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x7fffffff)), _mm256_set1_epi32(0x7f800000));
+    __m256i bits = _mm256_blendv_epi8(rounded, _mm256_or_si256(high, _mm256_set1_epi32(0x0040)), nan);
+    // narrow the 32-bit lanes to 16 bits, and gather the two 64-bit halves holding them into the lower 128 bits
+    bits = _mm256_permute4x64_epi64(_mm256_packus_epi32(bits, bits), 0xd8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(column + i), _mm256_castsi256_si128(bits));
+  }
+#endif
+  for (; i < count; ++i)
+    column[i].bits = soa_bfloat16::from_float(values[i]);
+}
+
+inline void soa_unpack(float* values, soa_bfloat16 const* column, size_t count) {
+  size_t i = 0;
+#if defined(__AVX2__) and not defined(__CUDACC__)
+  for (; i + 8 <= count; i += 8) {
+    __m256i bits = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<__m128i const*>(column + i)));
+    _mm256_storeu_ps(values + i, _mm256_castsi256_ps(_mm256_slli_epi32(bits, 16)));
+  }
+#endif
+  for (; i < count; ++i)
+    values[i] = soa_bfloat16::to_float(column[i].bits);
+}
+
+// when the number of bits divides 64 and the column starts on a word boundary, whole words are packed and unpacked with a
+// fixed number of shifts each; otherwise the elements are accessed one at a time
+template <typename PACKED>
+void soa_pack(soa_packed_column<PACKED> column, typename PACKED::value_type const* values, size_t count) {
+  static_assert(not std::is_const_v<PACKED>, "cannot pack values into a read-only column");
+  size_t i = 0;
+  if constexpr (64 % PACKED::bits == 0) {
+    constexpr size_t per_word = 64 / PACKED::bits;
+    if (column.first() % per_word == 0) {
+      uint64_t* words = column.words() + column.first() / per_word;
+      for (; i + per_word <= count; i += per_word) {
+        uint64_t word = 0;
+        for (size_t k = 0; k < per_word; ++k)
+          word |= (static_cast<uint64_t>(values[i + k]) & PACKED::mask) << (k * PACKED::bits);
+        words[i / per_word] = word;
+      }
+    }
+  }
+  for (; i < count; ++i)
+    column[i] = values[i];
+}
+
+template <typename PACKED>
+void soa_unpack(typename PACKED::value_type* values, soa_packed_column<PACKED> column, size_t count) {
+  using value_type = typename PACKED::value_type;
+  using packed_type = std::remove_const_t<PACKED>;
+  size_t i = 0;
+  if constexpr (64 % PACKED::bits == 0) {
+    constexpr size_t per_word = 64 / PACKED::bits;
+    if (column.first() % per_word == 0) {
+      uint64_t const* words = column.words() + column.first() / per_word;
+      for (; i + per_word <= count; i += per_word) {
+        uint64_t word = words[i / per_word];
+        for (size_t k = 0; k < per_word; ++k)
+          values[i + k] = static_cast<value_type>((word >> (k * PACKED::bits)) & PACKED::mask);
+      }
+    }
+  }
+  for (; i < count; ++i)
+    values[i] = packed_type::load(column.words(), column.first() + i);
+}
+
+namespace soa_detail {
+
+  // return the smallest integer greater than or equal to `x` that is a multiple of `n`
+  constexpr
+  size_t next_multiple(size_t x, size_t n) {
+    return (x + n - 1) / n * n;
+  }
+
+  // alignment of a field, given the alignment requested for the columns
+  constexpr
+  size_t field_alignment(soa_field_info const& field, size_t alignment) {
+    return (field.is_column and alignment > field.alignment) ? alignment : field.alignment;
+  }
+
+  // size in bytes of a field, for a SoA with `elements` elements; the bit-packed columns take whole 64-bit words
+  constexpr
+  size_t field_extent(soa_field_info const& field, size_t elements) {
+    if (field.bits)
+      return next_multiple(field.bits * elements, 64) / 8;
+    return field.is_column ? field.size * elements : field.size;
+  }
+
+  // alignment required by the buffer holding all the fields
+  template <size_t N>
+  constexpr
+  size_t buffer_alignment(soa_field_info const (&fields)[N], size_t alignment) {
+    size_t result = 1;
+    for (size_t i = 0; i < N; ++i)
+      result = std::max(result, field_alignment(fields[i], alignment));
+    return result;
+  }
+
+  // offsets of the fields inside a buffer holding `elements` elements, placed in the given order;
+  // the offsets are returned in declaration order, and the last entry holds the total size of the
+  // buffer, padded to the buffer alignment
+  template <size_t N>
+  constexpr
+  std::array<size_t, N + 1> field_offsets(soa_field_info const (&fields)[N], size_t elements, size_t alignment,
+                                          std::array<size_t, N> const& order) {
+    std::array<size_t, N + 1> offsets{};
+    size_t offset = 0;
+    for (size_t i : order) {
+      offset = next_multiple(offset, field_alignment(fields[i], alignment));
+      offsets[i] = offset;
+      offset += field_extent(fields[i], elements);
+    }
+    offsets[N] = next_multiple(offset, buffer_alignment(fields, alignment));
+    return offsets;
+  }
+
+  // copy the first `elements` elements of each column, and the scalars, between two buffers with different offsets
+  template <size_t N>
+  void copy_fields(soa_field_info const (&fields)[N], size_t elements, std::byte const* source,
+                   std::array<size_t, N + 1> const& source_offsets, std::byte* destination,
+                   std::array<size_t, N + 1> const& destination_offsets) {
+    for (size_t i = 0; i < N; ++i)
+      std::memcpy(destination + destination_offsets[i], source + source_offsets[i], field_extent(fields[i], elements));
+  }
+
+  // set the bits [first, last) of an array of 64-bit words to zero
+  inline void zero_bits(uint64_t* words, size_t first, size_t last) {
+    for (; first < last and first % 64; ++first)
+      words[first / 64] &= ~(uint64_t(1) << (first % 64));
+    std::memset(words + first / 64, 0, (last - first) / 64 * sizeof(uint64_t));
+    for (first += (last - first) / 64 * 64; first < last; ++first)
+      words[first / 64] &= ~(uint64_t(1) << (first % 64));
+  }
+
+  // value-initialise the elements [first, last) of each column, setting all their bytes (or bits) to zero
+  template <size_t N>
+  void zero_columns(soa_field_info const (&fields)[N], size_t first, size_t last, std::byte* buffer,
+                    std::array<size_t, N + 1> const& offsets) {
+    for (size_t i = 0; i < N; ++i)
+      if (fields[i].bits)
+        zero_bits(reinterpret_cast<uint64_t*>(buffer + offsets[i]), fields[i].bits * first, fields[i].bits * last);
+      else if (fields[i].is_column)
+        std::memset(buffer + offsets[i] + fields[i].size * first, 0, fields[i].size * (last - first));
+  }
+
+  // value-initialise the scalars, setting all their bytes to zero
+  template <size_t N>
+  void zero_scalars(soa_field_info const (&fields)[N], std::byte* buffer, std::array<size_t, N + 1> const& offsets) {
+    for (size_t i = 0; i < N; ++i)
+      if (not fields[i].is_column)
+        std::memset(buffer + offsets[i], 0, fields[i].size);
+  }
+
+  // pointer to a column of type T, stored at the given address inside a buffer
+  template <typename T>
+  SOA_HOST_DEVICE
+  soa_pointer_t<T> column_pointer(std::byte* data) {
+    return soa_column_traits<T>::make_pointer(reinterpret_cast<soa_storage_t<T>*>(data));
+  }
+
+  // read-only pointer to a column of type T const, stored inside a read-only buffer
+  template <typename T>
+  SOA_HOST_DEVICE
+  soa_pointer_t<T> column_pointer(std::byte const* data) {
+    static_assert(std::is_const_v<T>, "a read-only buffer holds read-only columns");
+    return soa_column_traits<T>::make_pointer(reinterpret_cast<soa_storage_t<T>*>(data));
+  }
+
+  // first byte and size in bytes of the storage of `count` elements of a column, starting from `column`, computed as in the
+  // layout of the buffer
+  template <typename T>
+  auto column_storage(T* column, size_t count) {
+    using byte_type = std::conditional_t<std::is_const_v<T>, std::byte const, std::byte>;
+    return std::make_pair(reinterpret_cast<byte_type*>(column),
+                          sizeof(T) * soa_column_traits<std::remove_const_t<T>>::storage_count(count));
+  }
+
+  // a bit-packed column must start on a word boundary; the last word may hold the bits of other elements
+  template <typename PACKED>
+  auto column_storage(soa_packed_column<PACKED> column, size_t count) {
+    using byte_type = std::conditional_t<std::is_const_v<PACKED>, std::byte const, std::byte>;
+    assert(column.first() * PACKED::bits % 64 == 0);
+    return std::make_pair(reinterpret_cast<byte_type*>(column.words() + column.first() * PACKED::bits / 64),
+                          sizeof(uint64_t) * soa_column_traits<std::remove_const_t<PACKED>>::storage_count(count));
+  }
+
+  // true if any of the fields is a bit-packed column, which is not addressable with a byte-sized stride
+  template <size_t N>
+  constexpr
+  bool has_packed_fields(soa_field_info const (&fields)[N]) {
+    for (size_t i = 0; i < N; ++i)
+      if (fields[i].bits)
+        return true;
+    return false;
+  }
+
+}  // namespace soa_detail
+
+
+// layout policies, setting the order in which the fields of a SoA with the given number of elements are placed inside a
+// buffer
+
+// place the fields in declaration order
+struct soa_declaration_order {
+  template <size_t N>
+  static constexpr
+  std::array<size_t, N> order(soa_field_info const (&fields)[N], size_t elements, size_t alignment) {
+    std::array<size_t, N> result{};
+    for (size_t i = 0; i < N; ++i)
+      result[i] = i;
+    return result;
+  }
+};
+
+// place the fields by decreasing alignment and size, minimising the padding between them; the padding after the last of
+// the most aligned fields can hold the less aligned ones, so each of the most aligned fields is also tried as the last one,
+// and the declaration order is kept if none of these orders takes less space
+struct soa_alignment_order {
+  template <size_t N>
+  static constexpr
+  std::array<size_t, N> order(soa_field_info const (&fields)[N], size_t elements, size_t alignment) {
+    auto before = [&](size_t a, size_t b) {
+      size_t align_a = soa_detail::field_alignment(fields[a], alignment);
+      size_t align_b = soa_detail::field_alignment(fields[b], alignment);
+      return (align_a != align_b) ? (align_a > align_b) : (fields[a].size > fields[b].size);
+    };
+    auto swap = [](size_t& a, size_t& b) {
+      size_t tmp = a;
+      a = b;
+      b = tmp;
+    };
+    auto data_size = [&](std::array<size_t, N> const& order) {
+      return soa_detail::field_offsets(fields, elements, alignment, order)[N];
+    };
+    // stable insertion sort, usable in a constant expression
+    std::array<size_t, N> sorted = soa_declaration_order::order(fields, elements, alignment);
+    for (size_t i = 1; i < N; ++i)
+      for (size_t j = i; j > 0 and before(sorted[j], sorted[j - 1]); --j)
+        swap(sorted[j], sorted[j - 1]);
+
+    // the most aligned fields come first
+    size_t first = 0;
+    while (first < N and soa_detail::field_alignment(fields[sorted[first]], alignment) ==
+                         soa_detail::field_alignment(fields[sorted[0]], alignment))
+      ++first;
+    std::array<size_t, N> result = sorted;
+    for (size_t last = 0; last + 1 < first; ++last) {
+      std::array<size_t, N> candidate = sorted;
+      for (size_t i = last; i + 1 < first; ++i)
+        swap(candidate[i], candidate[i + 1]);
+      if (data_size(candidate) < data_size(result))
+        result = candidate;
+    }
+    std::array<size_t, N> declared = soa_declaration_order::order(fields, elements, alignment);
+    return (data_size(declared) < data_size(result)) ? declared : result;
+  }
+};
+
+
+// allocator policy for the buffers owned by a SoA, returning memory with the requested alignment
+struct soa_aligned_allocator {
+  std::byte* allocate(size_t bytes, size_t alignment) {
+    return static_cast<std::byte*>(::operator new(bytes, std::align_val_t(alignment)));
+  }
+
+  void deallocate(std::byte* buffer, size_t bytes, size_t alignment) {
+    ::operator delete(buffer, bytes, std::align_val_t(alignment));
+  }
+};
+
+
+// dump the layout of a runtime sized SoA with the given number of elements, and the bytes saved with respect to
+// placing the fields in declaration order
+template <typename LAYOUT>
+SOA_HOST_ONLY
+void dump(size_t elements) {
+  auto const& fields = LAYOUT::fields;
+  auto offsets = LAYOUT::compute_offsets(elements);
+  auto declared = soa_detail::field_offsets(fields, elements, LAYOUT::alignment,
+                                            soa_declaration_order::order(fields, elements, LAYOUT::alignment));
+  std::cout << "layout for " << elements << " elements, aligned to " << LAYOUT::alignment << ":\n";
+  std::cout << "  buffer size: " << offsets.back() << '\n';
+  std::cout << "  buffer alignment: " << LAYOUT::buffer_alignment << '\n';
+  for (size_t i = 0; i < std::size(fields); ++i) {
+    std::cout << "  " << fields[i].name;
+    if (fields[i].is_column)
+      std::cout << "_[" << elements << "]";
+    else
+      std::cout << "_";
+    std::cout << " at " << offsets[i] << " has size " << soa_detail::field_extent(fields[i], elements) << '\n';
+  }
+  std::cout << "  saving " << static_cast<std::ptrdiff_t>(declared.back() - offsets.back()) << " bytes with respect to declaration order\n";
+  std::cout << std::endl;
+}
+
+
+// column of a tiled (AoSoA) SoA: the elements are contiguous within each tile of TILE elements,
+// and consecutive tiles are `stride` bytes apart
+template <typename T, size_t TILE>
+class soa_tiled_column {
+public:
+  using storage_type = soa_storage_t<T>;
+
+  SOA_HOST_DEVICE
+  soa_tiled_column(storage_type* first, size_t stride) :
+    first_(first),
+    stride_(stride)
+  { }
+
+  // the TILE contiguous elements of the tile `t`
+  SOA_HOST_DEVICE
+  soa_pointer_t<T> tile(size_t t) const {
+    using byte_type = std::conditional_t<std::is_const_v<storage_type>, std::byte const, std::byte>;
+    return soa_column_traits<T>::make_pointer(reinterpret_cast<storage_type*>(reinterpret_cast<byte_type*>(first_) + t * stride_));
+  }
+
+  SOA_HOST_DEVICE
+  soa_reference_t<T> operator[](size_t index) const {
+    return tile(index / TILE)[index % TILE];
+  }
+
+private:
+  storage_type* first_;
+  size_t stride_;
+};
+
+
+// random access iterator over the elements of a SoA, whose reference type is an AoS-like accessor
+// (the SoA element or const_element); HOLDER is a pointer to an owning SoA, or a copy of a (trivially copyable) view, so
+// that the iterators obtained from two temporary views over the same elements compare equal.
+// The reference type is a proxy: std::swap(*a, *b) and copying *a into a `value_type` copy the values of the elements, so
+// that the mutating standard algorithms like std::sort and std::rotate work, while a copy of a reference is another
+// accessor to the same element; the predicates of those algorithms are also called with `value_type` arguments.
+template <typename HOLDER, typename REFERENCE>
+class soa_iterator {
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = typename std::remove_cv_t<std::remove_pointer_t<HOLDER>>::value_type;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = REFERENCE;
+
+  soa_iterator() = default;
+
+  SOA_HOST_DEVICE
+  soa_iterator(HOLDER soa, size_t index) :
+    soa_(soa),
+    index_(index)
+  { }
+
+  // conversion from an iterator to a const iterator
+  template <typename OTHER_HOLDER, typename OTHER_REFERENCE,
+            typename = std::enable_if_t<std::is_convertible_v<OTHER_HOLDER, HOLDER> and
+                                        not std::is_same_v<OTHER_REFERENCE, REFERENCE>>>
+  SOA_HOST_DEVICE
+  soa_iterator(soa_iterator<OTHER_HOLDER, OTHER_REFERENCE> const& other) :
+    soa_(other.soa_),
+    index_(other.index_)
+  { }
+
+  SOA_HOST_DEVICE
+  reference operator*() const { return reference(soa(), index_); }
+
+  SOA_HOST_DEVICE
+  reference operator[](difference_type n) const { return reference(soa(), index_ + n); }
+
+  SOA_HOST_DEVICE
+  soa_iterator& operator++() { ++index_; return *this; }
+
+  SOA_HOST_DEVICE
+  soa_iterator operator++(int) { soa_iterator it = *this; ++index_; return it; }
+
+  SOA_HOST_DEVICE
+  soa_iterator& operator--() { --index_; return *this; }
+
+  SOA_HOST_DEVICE
+  soa_iterator operator--(int) { soa_iterator it = *this; --index_; return it; }
+
+  SOA_HOST_DEVICE
+  soa_iterator& operator+=(difference_type n) { index_ += n; return *this; }
+
+  SOA_HOST_DEVICE
+  soa_iterator& operator-=(difference_type n) { index_ -= n; return *this; }
+
+  SOA_HOST_DEVICE
+  soa_iterator operator+(difference_type n) const { soa_iterator it = *this; it += n; return it; }
+
+  SOA_HOST_DEVICE
+  soa_iterator operator-(difference_type n) const { soa_iterator it = *this; it -= n; return it; }
+
+  SOA_HOST_DEVICE
+  friend soa_iterator operator+(difference_type n, soa_iterator const& it) { return it + n; }
+
+  // the iterators can only be compared if they range over the same elements
+  SOA_HOST_DEVICE
+  difference_type operator-(soa_iterator const& other) const {
+    assert(same_soa(other));
+    return static_cast<difference_type>(index_ - other.index_);
+  }
+
+  SOA_HOST_DEVICE
+  bool operator==(soa_iterator const& other) const { assert(same_soa(other)); return index_ == other.index_; }
+
+  SOA_HOST_DEVICE
+  bool operator!=(soa_iterator const& other) const { return not (*this == other); }
+
+  SOA_HOST_DEVICE
+  bool operator<(soa_iterator const& other) const { assert(same_soa(other)); return index_ < other.index_; }
+
+  SOA_HOST_DEVICE
+  bool operator>(soa_iterator const& other) const { return (other < *this); }
+
+  SOA_HOST_DEVICE
+  bool operator<=(soa_iterator const& other) const { return not (*this > other); }
+
+  SOA_HOST_DEVICE
+  bool operator>=(soa_iterator const& other) const { return not (*this < other); }
+
+private:
+  template <typename, typename> friend class soa_iterator;
+
+  SOA_HOST_DEVICE
+  decltype(auto) soa() const {
+    if constexpr (std::is_pointer_v<HOLDER>)
+      return *soa_;
+    else
+      return (soa_);
+  }
+
+  // the same owning SoA, or views with the same column pointers and size
+  SOA_HOST_DEVICE
+  bool same_soa(soa_iterator const& other) const {
+    if constexpr (std::is_pointer_v<HOLDER>) {
+      return soa_ == other.soa_;
+    } else {
+      // the views hold only pointers and sizes, with no padding bytes, so equal views have equal bytes
+      static_assert(std::has_unique_object_representations_v<HOLDER>, "the views must be compared field by field");
+      auto const* a = reinterpret_cast<unsigned char const*>(&soa_);
+      auto const* b = reinterpret_cast<unsigned char const*>(&other.soa_);
+      for (size_t i = 0; i < sizeof(HOLDER); ++i)
+        if (a[i] != b[i])
+          return false;
+      return true;
+    }
+  }
+
+  HOLDER soa_{};
+  size_t index_ = 0;
+};
+
+
 // compile-time sized SoA
 
 /* declare "scalars" (one value shared across the whole SoA) and "columns" (one vale per element) */
 
 #define SoA_scalar(TYPE, NAME) (0, TYPE, NAME)
 #define SoA_column(TYPE, NAME) (1, TYPE, NAME)
- 
-
-/* declare SoA data members; these should exapnd to, for columns:
- *
- *   alignas(ALIGN) double x_[SIZE];
- *
- * and for scalars:
- *
- *   double x_;
- *
- */
 
-#define _DECLARE_SOA_DATA_MEMBER_IMPL(IS_COLUMN, TYPE, NAME)                                                                        \
-  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
-    alignas(ALIGN) TYPE BOOST_PP_CAT(NAME, _[SIZE]);                                                                                \
-  ,                                                                                                                                 \
-    TYPE BOOST_PP_CAT(NAME, _);                                                                                                     \
-  )
+/* declare columns with a reduced precision or bit-packed storage, see soa_column_traits */
 
-#define _DECLARE_SOA_DATA_MEMBER(R, DATA, TYPE_NAME)                                                                                \
-  BOOST_PP_EXPAND(_DECLARE_SOA_DATA_MEMBER_IMPL TYPE_NAME)
+#define SoA_half_column(NAME) (1, soa_half, NAME)
+#define SoA_bfloat16_column(NAME) (1, soa_bfloat16, NAME)
+#define SoA_packed_column(BITS, NAME) (1, soa_packed<BITS>, NAME)
+#define SoA_flag_column(NAME) (1, soa_flag, NAME)
 
-#define _DECLARE_SOA_DATA_MEMBERS(...)                                                                                              \
-  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_DATA_MEMBER, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+/* declare a column with a validity bitmap, i.e. a column NAME followed by a flag column NAME_valid, see soa_mask.h; a
+ * validity bitmap for whole rows is just a flag column */
 
+#define SoA_nullable_column(TYPE, NAME) (1, TYPE, NAME), (1, soa_flag, BOOST_PP_CAT(NAME, _valid))
+ 
 
-/* declare SoA accessors; these should expand to, for columns:
+/* declare SoA accessors to the fields inside the buffer_ data member, at the offsets_ of the field I; these should expand
+ * to, for columns:
  *
- *   double* x() { return x_; }
+ *   soa_pointer_t<double> x() { return soa_detail::column_pointer<double>(buffer_ + offsets_[I]); }
  *
  * and for scalars:
  *
- *   double& x() { return x_; }
+ *   double& x() { return *reinterpret_cast<double*>(buffer_ + offsets_[I]); }
  *
  */
 
-#define _DECLARE_SOA_ACCESSOR_IMPL(IS_COLUMN, TYPE, NAME)                                                                           \
+#define _DECLARE_SOA_ACCESSOR_IMPL(I, IS_COLUMN, TYPE, NAME)                                                                        \
   SOA_HOST_DEVICE                                                                                                                   \
   BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
-    TYPE* NAME() { return BOOST_PP_CAT(NAME, _); }                                                                                  \
+    soa_pointer_t<TYPE> NAME() { return soa_detail::column_pointer<TYPE>(buffer_ + offsets_[I]); }                                  \
   ,                                                                                                                                 \
-    TYPE& NAME() { return BOOST_PP_CAT(NAME, _); }                                                                                  \
+    TYPE& NAME() { return *reinterpret_cast<TYPE*>(buffer_ + offsets_[I]); }                                                        \
   )
 
-#define _DECLARE_SOA_ACCESSOR(R, DATA, TYPE_NAME)                                                                                   \
-  BOOST_PP_EXPAND(_DECLARE_SOA_ACCESSOR_IMPL TYPE_NAME)
+#define _DECLARE_SOA_ACCESSOR(R, DATA, I, TYPE_NAME)                                                                                \
+  BOOST_PP_EXPAND(_DECLARE_SOA_ACCESSOR_IMPL BOOST_PP_TUPLE_PUSH_FRONT(TYPE_NAME, I))
 
 #define _DECLARE_SOA_ACCESSORS(...)                                                                                                 \
-  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_ACCESSOR, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+  BOOST_PP_SEQ_FOR_EACH_I(_DECLARE_SOA_ACCESSOR, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
 
 
-#define _DECLARE_SOA_CONST_ACCESSOR_IMPL(IS_COLUMN, TYPE, NAME)                                                                     \
+#define _DECLARE_SOA_CONST_ACCESSOR_IMPL(I, IS_COLUMN, TYPE, NAME)                                                                  \
   SOA_HOST_DEVICE                                                                                                                   \
   BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
-    TYPE const* NAME() const { return BOOST_PP_CAT(NAME, _); }                                                                      \
+    soa_pointer_t<TYPE const> NAME() const { return soa_detail::column_pointer<TYPE const>(buffer_ + offsets_[I]); }                \
   ,                                                                                                                                 \
-    TYPE const& NAME() const { return BOOST_PP_CAT(NAME, _); }                                                                      \
+    TYPE const& NAME() const { return *reinterpret_cast<TYPE const*>(buffer_ + offsets_[I]); }                                      \
   )
 
-#define _DECLARE_SOA_CONST_ACCESSOR(R, DATA, TYPE_NAME)                                                                             \
-  BOOST_PP_EXPAND(_DECLARE_SOA_CONST_ACCESSOR_IMPL TYPE_NAME)
+#define _DECLARE_SOA_CONST_ACCESSOR(R, DATA, I, TYPE_NAME)                                                                          \
+  BOOST_PP_EXPAND(_DECLARE_SOA_CONST_ACCESSOR_IMPL BOOST_PP_TUPLE_PUSH_FRONT(TYPE_NAME, I))
 
 #define _DECLARE_SOA_CONST_ACCESSORS(...)                                                                                           \
-  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_CONST_ACCESSOR, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+  BOOST_PP_SEQ_FOR_EACH_I(_DECLARE_SOA_CONST_ACCESSOR, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
 
 
 /* assignment of individual fields; these should expand to, for columns
@@ -108,22 +922,83 @@
   BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_ELEMENT_ASSIGNMENT, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
 
 
+/* declare the members of the struct with value semantics corresponding to an individual element; these should expand to,
+ * for columns:
+ *
+ *   soa_value_t<double> x;
+ *
+ * and to nothing for scalars.
+ */
+
+#define _DECLARE_SOA_VALUE_MEMBER_IMPL(IS_COLUMN, TYPE, NAME)                                                                       \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    soa_value_t<TYPE> NAME;                                                                                                         \
+  ,                                                                                                                                 \
+  )
+
+#define _DECLARE_SOA_VALUE_MEMBER(R, DATA, TYPE_NAME)                                                                               \
+  BOOST_PP_EXPAND(_DECLARE_SOA_VALUE_MEMBER_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_VALUE_MEMBERS(...)                                                                                             \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_VALUE_MEMBER, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* assignment of individual fields from a value; these should expand to, for columns
+ *
+ *   x() = other.x;
+ *
+ * and to nothing for scalars.
+ */
+
+#define _DECLARE_SOA_ELEMENT_VALUE_ASSIGNMENT_IMPL(IS_COLUMN, TYPE, NAME)                                                           \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    NAME() = other.NAME;                                                                                                            \
+  ,                                                                                                                                 \
+  )
+
+#define _DECLARE_SOA_ELEMENT_VALUE_ASSIGNMENT(R, DATA, TYPE_NAME)                                                                   \
+  BOOST_PP_EXPAND(_DECLARE_SOA_ELEMENT_VALUE_ASSIGNMENT_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_ELEMENT_VALUE_ASSIGNMENTS(...)                                                                                 \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_ELEMENT_VALUE_ASSIGNMENT, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* conversion of individual fields to a value; these should expand to, for columns
+ *
+ *   result.x = x();
+ *
+ * and to nothing for scalars.
+ */
+
+#define _DECLARE_SOA_ELEMENT_VALUE_CONVERSION_IMPL(IS_COLUMN, TYPE, NAME)                                                           \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    result.NAME = NAME();                                                                                                           \
+  ,                                                                                                                                 \
+  )
+
+#define _DECLARE_SOA_ELEMENT_VALUE_CONVERSION(R, DATA, TYPE_NAME)                                                                   \
+  BOOST_PP_EXPAND(_DECLARE_SOA_ELEMENT_VALUE_CONVERSION_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_ELEMENT_VALUE_CONVERSIONS(...)                                                                                 \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_ELEMENT_VALUE_CONVERSION, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
 /* declare AoS-like element accessors; these should expand to, for columns:
  *
- *   double & x() { return * (soa_.x() + index_); }
+ *   soa_reference_t<double> x() const { return soa_.x()[index_]; }
  *
  * and for scalars:
  *
- *   double & x() { return soa_.x(); }
+ *   double & x() const { return soa_.x(); }
  *
  */
 
 #define _DECLARE_SOA_ELEMENT_ACCESSOR_IMPL(IS_COLUMN, TYPE, NAME)                                                                   \
   SOA_HOST_DEVICE                                                                                                                   \
   BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
-    TYPE & NAME() { return * (soa_. NAME () + index_); }                                                                            \
+    soa_reference_t<TYPE> NAME() const { return soa_. NAME ()[index_]; }                                                            \
   ,                                                                                                                                 \
-    TYPE & NAME() { return soa_. NAME (); }                                                                                         \
+    TYPE & NAME() const { return soa_. NAME (); }                                                                                   \
   )
 
 #define _DECLARE_SOA_ELEMENT_ACCESSOR(R, DATA, TYPE_NAME)                                                                           \
@@ -136,9 +1011,9 @@
 #define _DECLARE_SOA_CONST_ELEMENT_ACCESSOR_IMPL(IS_COLUMN, TYPE, NAME)                                                             \
   SOA_HOST_DEVICE                                                                                                                   \
   BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
-    TYPE const & NAME() { return * (soa_. NAME () + index_); }                                                                      \
+    soa_reference_t<TYPE const> NAME() const { return soa_. NAME ()[index_]; }                                                      \
   ,                                                                                                                                 \
-    TYPE const & NAME() { return soa_. NAME (); }                                                                                   \
+    TYPE const & NAME() const { return soa_. NAME (); }                                                                             \
   )
 
 #define _DECLARE_SOA_CONST_ELEMENT_ACCESSOR(R, DATA, TYPE_NAME)                                                                     \
@@ -148,121 +1023,1270 @@
   BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_CONST_ELEMENT_ACCESSOR, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
 
 
-/* dump SoA fields information; these should expand to, for columns:
+/* declare the pointers to the SoA fields in a view; these should expand to, for both columns and scalars:
+ *
+ *   soa_pointer_t<double CONST> x_ = {};
+ *
+ */
+
+#define _DECLARE_SOA_VIEW_MEMBER_IMPL(CONST, IS_COLUMN, TYPE, NAME)                                                                 \
+  soa_pointer_t<TYPE CONST> BOOST_PP_CAT(NAME, _) = {};
+
+#define _DECLARE_SOA_VIEW_MEMBER(R, CONST, TYPE_NAME)                                                                               \
+  BOOST_PP_EXPAND(_DECLARE_SOA_VIEW_MEMBER_IMPL BOOST_PP_TUPLE_PUSH_FRONT(TYPE_NAME, CONST))
+
+#define _DECLARE_SOA_VIEW_MEMBERS(CONST, ...)                                                                                       \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_VIEW_MEMBER, CONST, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* check that the storage of the SoA fields can be copied with memcpy; these should expand to, for both columns and scalars:
  *
- *   std::cout << "  x_[" << SoA::size << "] at " 
- *             << offsetof(SoA, SoA::x_) << " has size " << sizeof(SoA::x_) << std::endl;
+ *   static_assert(std::is_trivially_copyable_v<soa_storage_t<double>>, "...");
+ *
+ */
+
+#define _DECLARE_SOA_TRIVIALLY_COPYABLE_IMPL(IS_COLUMN, TYPE, NAME)                                                                 \
+  static_assert(std::is_trivially_copyable_v<soa_storage_t<TYPE>>,                                                                  \
+                "the field " BOOST_PP_STRINGIZE(NAME) " must be trivially copyable");
+
+#define _DECLARE_SOA_TRIVIALLY_COPYABLE(R, DATA, TYPE_NAME)                                                                         \
+  BOOST_PP_EXPAND(_DECLARE_SOA_TRIVIALLY_COPYABLE_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_TRIVIALLY_COPYABLES(...)                                                                                       \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_TRIVIALLY_COPYABLE, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* declare the view accessors; like std::span, a view does not propagate its constness to the data it points to.
+ * These should expand to, for columns:
+ *
+ *   soa_pointer_t<double CONST> x() const { return x_; }
  *
  * and for scalars:
  *
- *   std::cout << "  x_ at " 
- *             << offsetof(SoA, SoA::x_) << " has size " << sizeof(SoA::x_) << std::endl;
+ *   double CONST & x() const { return * x_; }
  *
  */
 
-#define _DECLARE_SOA_DUMP_INFO_IMPL(IS_COLUMN, TYPE, NAME)                                                                          \
+#define _DECLARE_SOA_VIEW_ACCESSOR_IMPL(CONST, IS_COLUMN, TYPE, NAME)                                                               \
+  SOA_HOST_DEVICE                                                                                                                   \
   BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
-    std::cout << "  " BOOST_PP_STRINGIZE(NAME) "_[" << SoA::size << "] at "                                                         \
-              << offsetof(SoA, SoA:: BOOST_PP_CAT(NAME, _)) << " has size " << sizeof(SoA:: BOOST_PP_CAT(NAME, _)) << std::endl;    \
+    soa_pointer_t<TYPE CONST> NAME() const { return BOOST_PP_CAT(NAME, _); }                                                        \
   ,                                                                                                                                 \
-    std::cout << "  " BOOST_PP_STRINGIZE(NAME) "_ at "                                                                              \
-              << offsetof(SoA, SoA:: BOOST_PP_CAT(NAME, _)) << " has size " << sizeof(SoA:: BOOST_PP_CAT(NAME, _)) << std::endl;    \
+    TYPE CONST & NAME() const { return * BOOST_PP_CAT(NAME, _); }                                                                   \
   )
 
-#define _DECLARE_SOA_DUMP_INFO(R, DATA, TYPE_NAME)                                                                                  \
-  BOOST_PP_EXPAND(_DECLARE_SOA_DUMP_INFO_IMPL TYPE_NAME)
+#define _DECLARE_SOA_VIEW_ACCESSOR(R, CONST, TYPE_NAME)                                                                             \
+  BOOST_PP_EXPAND(_DECLARE_SOA_VIEW_ACCESSOR_IMPL BOOST_PP_TUPLE_PUSH_FRONT(TYPE_NAME, CONST))
 
-#define _DECLARE_SOA_DUMP_INFOS(...)                                                                                                \
-  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_DUMP_INFO, CLASS, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+#define _DECLARE_SOA_VIEW_ACCESSORS(CONST, ...)                                                                                     \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_VIEW_ACCESSOR, CONST, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
 
 
-#define declare_SoA_template(CLASS, ...)                                                                                            \
-                                                                                                                                    \
-/* dump the SoA internaul structure */                                                                                              \
-template <typename T>                                                                                                               \
-SOA_HOST_ONLY                                                                                                                       \
-void dump() {                                                                                                                       \
-  using SoA = T;                                                                                                                    \
-  std::cout << #CLASS "<" << SoA::size << ", " << SoA::alignment << "): " << '\n';                                                  \
-  std::cout << "  sizeof(...): " << sizeof(CLASS) << '\n';                                                                          \
-  std::cout << "  alignof(...): " << alignof(CLASS) << '\n';                                                                        \
-  _DECLARE_SOA_DUMP_INFOS(__VA_ARGS__)                                                                                              \
-  std::cout << std::endl;                                                                                                           \
-}                                                                                                                                   \
-                                                                                                                                    \
-template <size_t SIZE, size_t ALIGN=0>                                                                                              \
-struct CLASS {                                                                                                                      \
-                                                                                                                                    \
-  /* these could be moved to an external type trait to free up the symbol names */                                                  \
-  using self_type = CLASS;                                                                                                          \
-  static const size_t size = SIZE;                                                                                                  \
-  static const size_t alignment = ALIGN;                                                                                            \
-                                                                                                                                    \
-  /* AoS-like accessor to individual elements */                                                                                    \
-  struct const_element {                                                                                                            \
-    SOA_HOST_DEVICE                                                                                                                 \
-    const_element(CLASS const& soa, int index) :                                                                                    \
-      soa_(soa),                                                                                                                    \
-      index_(index)                                                                                                                 \
-    { }                                                                                                                             \
-                                                                                                                                    \
-    _DECLARE_SOA_CONST_ELEMENT_ACCESSORS(__VA_ARGS__)                                                                               \
-                                                                                                                                    \
-  private:                                                                                                                          \
-    CLASS const& soa_;                                                                                                              \
-    const int index_;                                                                                                               \
-  };                                                                                                                                \
-                                                                                                                                    \
-  struct element {                                                                                                                  \
-    SOA_HOST_DEVICE                                                                                                                 \
-    element(CLASS & soa, size_t index) :                                                                                            \
-      soa_(soa),                                                                                                                    \
-      index_(index)                                                                                                                 \
-    { }                                                                                                                             \
-                                                                                                                                    \
-    SOA_HOST_DEVICE                                                                                                                 \
-    element& operator=(element const& other) {                                                                                      \
-      _DECLARE_SOA_ELEMENT_ASSIGNMENTS(__VA_ARGS__)                                                                                 \
-      return *this;                                                                                                                 \
-    }                                                                                                                               \
-                                                                                                                                    \
-    SOA_HOST_DEVICE                                                                                                                 \
-    element& operator=(element && other) {                                                                                          \
-      _DECLARE_SOA_ELEMENT_ASSIGNMENTS(__VA_ARGS__)                                                                                 \
-      return *this;                                                                                                                 \
-    }                                                                                                                               \
-                                                                                                                                    \
-    SOA_HOST_DEVICE                                                                                                                 \
-    element& operator=(const_element const& other) {                                                                                \
-      _DECLARE_SOA_ELEMENT_ASSIGNMENTS(__VA_ARGS__)                                                                                 \
-      return *this;                                                                                                                 \
-    }                                                                                                                               \
-                                                                                                                                    \
-    SOA_HOST_DEVICE                                                                                                                 \
-    element& operator=(const_element && other) {                                                                                    \
-      _DECLARE_SOA_ELEMENT_ASSIGNMENTS(__VA_ARGS__)                                                                                 \
+/* point a view to the data members of a compile-time sized SoA; these should expand to, for columns:
+ *
+ *   result.x_ = x();
+ *
+ * and for scalars:
+ *
+ *   result.x_ = & x();
+ *
+ */
+
+#define _DECLARE_SOA_VIEW_FROM_DATA_MEMBER_IMPL(IS_COLUMN, TYPE, NAME)                                                              \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    result.BOOST_PP_CAT(NAME, _) = NAME();                                                                                          \
+  ,                                                                                                                                 \
+    result.BOOST_PP_CAT(NAME, _) = & NAME();                                                                                        \
+  )
+
+#define _DECLARE_SOA_VIEW_FROM_DATA_MEMBER(R, DATA, TYPE_NAME)                                                                      \
+  BOOST_PP_EXPAND(_DECLARE_SOA_VIEW_FROM_DATA_MEMBER_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_VIEW_FROM_DATA_MEMBERS(...)                                                                                    \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_VIEW_FROM_DATA_MEMBER, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* point a view to the SoA fields, given their offsets inside a buffer; these should expand to, for the field I:
+ *
+ *   x_ = soa_detail::column_pointer<double>(buffer_ + offsets[I]);
+ *
+ */
+
+#define _DECLARE_SOA_VIEW_FROM_BUFFER_IMPL(I, IS_COLUMN, TYPE, NAME)                                                                \
+  BOOST_PP_CAT(NAME, _) = soa_detail::column_pointer<TYPE>(buffer_ + offsets[I]);
+
+#define _DECLARE_SOA_VIEW_FROM_BUFFER(R, DATA, I, TYPE_NAME)                                                                        \
+  BOOST_PP_EXPAND(_DECLARE_SOA_VIEW_FROM_BUFFER_IMPL BOOST_PP_TUPLE_PUSH_FRONT(TYPE_NAME, I))
+
+#define _DECLARE_SOA_VIEW_FROM_BUFFERS(...)                                                                                         \
+  BOOST_PP_SEQ_FOR_EACH_I(_DECLARE_SOA_VIEW_FROM_BUFFER, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* copy the pointers from an other view; these should expand to, for both columns and scalars:
+ *
+ *   x_ = other.x_;
+ *
+ */
+
+#define _DECLARE_SOA_VIEW_COPY_IMPL(IS_COLUMN, TYPE, NAME)                                                                          \
+  BOOST_PP_CAT(NAME, _) = other.BOOST_PP_CAT(NAME, _);
+
+#define _DECLARE_SOA_VIEW_COPY(R, DATA, TYPE_NAME)                                                                                  \
+  BOOST_PP_EXPAND(_DECLARE_SOA_VIEW_COPY_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_VIEW_COPIES(...)                                                                                               \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_VIEW_COPY, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* move the columns of a view to a sub-range of elements; these should expand to, for columns:
+ *
+ *   result.x_ += offset;
+ *
+ * and to nothing for scalars.
+ */
+
+#define _DECLARE_SOA_VIEW_OFFSET_IMPL(IS_COLUMN, TYPE, NAME)                                                                        \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    result.BOOST_PP_CAT(NAME, _) += offset;                                                                                         \
+  ,                                                                                                                                 \
+  )
+
+#define _DECLARE_SOA_VIEW_OFFSET(R, DATA, TYPE_NAME)                                                                                \
+  BOOST_PP_EXPAND(_DECLARE_SOA_VIEW_OFFSET_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_VIEW_OFFSETS(...)                                                                                              \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_VIEW_OFFSET, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* copy a block of elements from an array of structures to the columns of a view; these should expand to, for columns:
+ *
+ *   for (size_t i = first; i < last; ++i)
+ *     x_[i] = data[i].x;
+ *
+ * and to nothing for scalars.
+ */
+
+#define _DECLARE_SOA_VIEW_FROM_AOS_IMPL(IS_COLUMN, TYPE, NAME)                                                                      \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    for (size_t i = first; i < last; ++i)                                                                                           \
+      BOOST_PP_CAT(NAME, _)[i] = data[i].NAME;                                                                                      \
+  ,                                                                                                                                 \
+  )
+
+#define _DECLARE_SOA_VIEW_FROM_AOS(R, DATA, TYPE_NAME)                                                                              \
+  BOOST_PP_EXPAND(_DECLARE_SOA_VIEW_FROM_AOS_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_VIEW_FROM_AOSS(...)                                                                                            \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_VIEW_FROM_AOS, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* copy a block of elements from the columns of a view to an array of structures; these should expand to, for columns:
+ *
+ *   for (size_t i = first; i < last; ++i)
+ *     data[i].x = x_[i];
+ *
+ * and to nothing for scalars.
+ */
+
+#define _DECLARE_SOA_VIEW_TO_AOS_IMPL(IS_COLUMN, TYPE, NAME)                                                                        \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    for (size_t i = first; i < last; ++i)                                                                                           \
+      data[i].NAME = BOOST_PP_CAT(NAME, _)[i];                                                                                      \
+  ,                                                                                                                                 \
+  )
+
+#define _DECLARE_SOA_VIEW_TO_AOS(R, DATA, TYPE_NAME)                                                                                \
+  BOOST_PP_EXPAND(_DECLARE_SOA_VIEW_TO_AOS_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_VIEW_TO_AOSS(...)                                                                                              \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_VIEW_TO_AOS, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* declare the members of a tile of a tiled SoA; these should expand to, for columns:
+ *
+ *   alignas(ALIGN) soa_storage_t<double> x[soa_column_traits<double>::storage_count(TILE)];
+ *
+ * and to nothing for scalars.
+ */
+
+#define _DECLARE_SOA_TILE_MEMBER_IMPL(IS_COLUMN, TYPE, NAME)                                                                        \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    alignas(ALIGN) soa_storage_t<TYPE> NAME[soa_column_traits<TYPE>::storage_count(TILE)];                                          \
+  ,                                                                                                                                 \
+  )
+
+#define _DECLARE_SOA_TILE_MEMBER(R, DATA, TYPE_NAME)                                                                                \
+  BOOST_PP_EXPAND(_DECLARE_SOA_TILE_MEMBER_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_TILE_MEMBERS(...)                                                                                              \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_TILE_MEMBER, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* declare the scalars of a tiled SoA; these should expand to, for scalars:
+ *
+ *   double x;
+ *
+ * and to nothing for columns.
+ */
+
+#define _DECLARE_SOA_TILED_SCALAR_MEMBER_IMPL(IS_COLUMN, TYPE, NAME)                                                                \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+  ,                                                                                                                                 \
+    TYPE NAME;                                                                                                                      \
+  )
+
+#define _DECLARE_SOA_TILED_SCALAR_MEMBER(R, DATA, TYPE_NAME)                                                                        \
+  BOOST_PP_EXPAND(_DECLARE_SOA_TILED_SCALAR_MEMBER_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_TILED_SCALAR_MEMBERS(...)                                                                                      \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_TILED_SCALAR_MEMBER, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* declare the tiled SoA accessors; these should expand to, for columns:
+ *
+ *   column_type<double> x() const { return column_type<double>(tiles_->x, sizeof(tile_type)); }
+ *
+ * and for scalars:
+ *
+ *   double & x() const { return scalars_->x; }
+ *
+ */
+
+#define _DECLARE_SOA_TILED_ACCESSOR_IMPL(IS_COLUMN, TYPE, NAME)                                                                     \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    column_type<TYPE> NAME() const { return column_type<TYPE>(tiles_->NAME, sizeof(tile_type)); }                                   \
+  ,                                                                                                                                 \
+    TYPE & NAME() const { return scalars_->NAME; }                                                                                  \
+  )
+
+#define _DECLARE_SOA_TILED_ACCESSOR(R, DATA, TYPE_NAME)                                                                             \
+  BOOST_PP_EXPAND(_DECLARE_SOA_TILED_ACCESSOR_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_TILED_ACCESSORS(...)                                                                                           \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_TILED_ACCESSOR, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* build tuples of pointers to the columns or to the scalars, to be used as
+ *
+ *   std::tuple_cat(std::tuple<>() _DECLARE_SOA_COLUMN_TUPLE(...))
+ *
+ * these should expand to, for columns (or scalars, respectively):
+ *
+ *   , std::make_tuple(x_)
+ *
+ * and to nothing otherwise.
+ */
+
+#define _DECLARE_SOA_TUPLE_ELEMENT(NAME)                                                                                            \
+  , std::make_tuple(BOOST_PP_CAT(NAME, _))
+
+#define _DECLARE_SOA_COLUMN_TUPLE_ELEMENT_IMPL(IS_COLUMN, TYPE, NAME)                                                               \
+  BOOST_PP_IIF(IS_COLUMN, _DECLARE_SOA_TUPLE_ELEMENT, BOOST_PP_TUPLE_EAT(1))(NAME)
+
+#define _DECLARE_SOA_COLUMN_TUPLE_ELEMENT(R, DATA, TYPE_NAME)                                                                       \
+  _DECLARE_SOA_COLUMN_TUPLE_ELEMENT_IMPL TYPE_NAME
+
+#define _DECLARE_SOA_COLUMN_TUPLE(...)                                                                                              \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_COLUMN_TUPLE_ELEMENT, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+#define _DECLARE_SOA_SCALAR_TUPLE_ELEMENT_IMPL(IS_COLUMN, TYPE, NAME)                                                               \
+  BOOST_PP_IIF(IS_COLUMN, BOOST_PP_TUPLE_EAT(1), _DECLARE_SOA_TUPLE_ELEMENT)(NAME)
+
+#define _DECLARE_SOA_SCALAR_TUPLE_ELEMENT(R, DATA, TYPE_NAME)                                                                       \
+  _DECLARE_SOA_SCALAR_TUPLE_ELEMENT_IMPL TYPE_NAME
+
+#define _DECLARE_SOA_SCALAR_TUPLE(...)                                                                                              \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_SCALAR_TUPLE_ELEMENT, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+/* build a tuple of pointers to all the fields, in declaration order, to be used as
+ *
+ *   std::tuple_cat(std::tuple<>() _DECLARE_SOA_FIELD_TUPLE(...))
+ *
+ * these should expand to, for both columns and scalars:
+ *
+ *   , std::make_tuple(x_)
+ */
+
+#define _DECLARE_SOA_FIELD_TUPLE_ELEMENT_IMPL(IS_COLUMN, TYPE, NAME)                                                                \
+  _DECLARE_SOA_TUPLE_ELEMENT(NAME)
+
+#define _DECLARE_SOA_FIELD_TUPLE_ELEMENT(R, DATA, TYPE_NAME)                                                                        \
+  _DECLARE_SOA_FIELD_TUPLE_ELEMENT_IMPL TYPE_NAME
+
+#define _DECLARE_SOA_FIELD_TUPLE(...)                                                                                               \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_FIELD_TUPLE_ELEMENT, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* declare the enumerators naming the fields; these should expand to, for both columns and scalars:
+ *
+ *   x,
+ *
+ */
+
+#define _DECLARE_SOA_FIELD_ENUMERATOR_IMPL(IS_COLUMN, TYPE, NAME)                                                                   \
+  NAME,
+
+#define _DECLARE_SOA_FIELD_ENUMERATOR(R, DATA, TYPE_NAME)                                                                           \
+  _DECLARE_SOA_FIELD_ENUMERATOR_IMPL TYPE_NAME
+
+#define _DECLARE_SOA_FIELD_ENUMERATORS(...)                                                                                         \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_FIELD_ENUMERATOR, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* declare the projection accessors, valid only for the selected fields; these should expand to, for columns:
+ *
+ *   auto x() const { return get<SoAField::x>(); }
+ *
+ * and for scalars:
+ *
+ *   auto & x() const { return * get<SoAField::x>(); }
+ *
+ */
+
+#define _DECLARE_SOA_PROJECTION_ACCESSOR_IMPL(CLASS, IS_COLUMN, TYPE, NAME)                                                         \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    auto NAME() const { return get<BOOST_PP_CAT(CLASS, Field)::NAME>(); }                                                           \
+  ,                                                                                                                                 \
+    auto & NAME() const { return * get<BOOST_PP_CAT(CLASS, Field)::NAME>(); }                                                       \
+  )
+
+#define _DECLARE_SOA_PROJECTION_ACCESSOR(R, CLASS, TYPE_NAME)                                                                       \
+  BOOST_PP_EXPAND(_DECLARE_SOA_PROJECTION_ACCESSOR_IMPL BOOST_PP_TUPLE_PUSH_FRONT(TYPE_NAME, CLASS))
+
+#define _DECLARE_SOA_PROJECTION_ACCESSORS(CLASS, ...)                                                                               \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_PROJECTION_ACCESSOR, CLASS, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* declare the accessors of the elements of a projection, valid only for the selected fields; these should expand to,
+ * for columns:
+ *
+ *   decltype(auto) x() const { return soa_.x()[index_]; }
+ *
+ * and for scalars:
+ *
+ *   decltype(auto) x() const { return soa_.x(); }
+ *
+ */
+
+#define _DECLARE_SOA_PROJECTION_ELEMENT_ACCESSOR_IMPL(IS_COLUMN, TYPE, NAME)                                                        \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    decltype(auto) NAME() const { return soa_. NAME ()[index_]; }                                                                   \
+  ,                                                                                                                                 \
+    decltype(auto) NAME() const { return soa_. NAME (); }                                                                           \
+  )
+
+#define _DECLARE_SOA_PROJECTION_ELEMENT_ACCESSOR(R, DATA, TYPE_NAME)                                                                \
+  BOOST_PP_EXPAND(_DECLARE_SOA_PROJECTION_ELEMENT_ACCESSOR_IMPL TYPE_NAME)
+
+#define _DECLARE_SOA_PROJECTION_ELEMENT_ACCESSORS(...)                                                                              \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_PROJECTION_ELEMENT_ACCESSOR, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+
+/* describe the SoA fields; these should expand to, for columns:
+ *
+ *   { "x", soa_column_traits<double>::size, alignof(soa_storage_t<double>), true, soa_column_traits<double>::bits },
+ *
+ * and for scalars:
+ *
+ *   { "x", soa_column_traits<double>::size, alignof(soa_storage_t<double>), false, soa_column_traits<double>::bits },
+ *
+ */
+
+#define _DECLARE_SOA_FIELD_INFO_IMPL(IS_COLUMN, TYPE, NAME)                                                                         \
+  { BOOST_PP_STRINGIZE(NAME), soa_column_traits<TYPE>::size, alignof(soa_storage_t<TYPE>), BOOST_PP_IIF(IS_COLUMN, true, false),    \
+    soa_column_traits<TYPE>::bits },
+
+#define _DECLARE_SOA_FIELD_INFO(R, DATA, TYPE_NAME)                                                                                 \
+  _DECLARE_SOA_FIELD_INFO_IMPL TYPE_NAME
+
+#define _DECLARE_SOA_FIELD_INFOS(...)                                                                                               \
+  BOOST_PP_SEQ_FOR_EACH(_DECLARE_SOA_FIELD_INFO, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+/* declare the AoS-like accessors to individual elements of a SoA, holding on to the SoA through CONST_HOLDER: a reference
+ * for the owning SoAs, and a copy for the (trivially copyable) views, so that an element stays valid after the view it was
+ * obtained from is destroyed; the enclosing type must define value_type.
+ * The accessors are templates only to defer their definition until the enclosing type is complete, so that they can hold
+ * a copy of it.
+ */
+
+#define _DECLARE_SOA_CONST_ELEMENT_TYPE(CONST_HOLDER, ...)                                                                          \
+  template <typename HOLDER = CONST_HOLDER>                                                                                         \
+  struct const_element_type {                                                                                                       \
+    SOA_HOST_DEVICE                                                                                                                 \
+    const_element_type(HOLDER soa, size_t index) :                                                                                  \
+      soa_(soa),                                                                                                                    \
+      index_(index)                                                                                                                 \
+    { }                                                                                                                             \
+                                                                                                                                    \
+    SOA_HOST_DEVICE                                                                                                                 \
+    operator value_type() const {                                                                                                   \
+      value_type result;                                                                                                            \
+      _DECLARE_SOA_ELEMENT_VALUE_CONVERSIONS(__VA_ARGS__)                                                                           \
+      return result;                                                                                                                \
+    }                                                                                                                               \
+                                                                                                                                    \
+    _DECLARE_SOA_CONST_ELEMENT_ACCESSORS(__VA_ARGS__)                                                                               \
+                                                                                                                                    \
+  private:                                                                                                                          \
+    HOLDER soa_;                                                                                                                    \
+    const size_t index_;                                                                                                            \
+  };                                                                                                                                \
+                                                                                                                                    \
+  using const_element = const_element_type<>;
+
+
+/* declare the AoS-like accessors to individual elements of a SoA, holding on to the SoA through CONST_HOLDER and HOLDER
+ * respectively, e.g. CLASS const & and CLASS & for the owning SoA, or CLASSView const for both for a view
+ */
+
+#define _DECLARE_SOA_ELEMENT_TYPES(CONST_HOLDER, HOLDER, ...)                                                                       \
+  _DECLARE_SOA_CONST_ELEMENT_TYPE(CONST_HOLDER, __VA_ARGS__)                                                                        \
+                                                                                                                                    \
+  template <typename ELEMENT_HOLDER = HOLDER>                                                                                       \
+  struct element_type {                                                                                                             \
+    SOA_HOST_DEVICE                                                                                                                 \
+    element_type(ELEMENT_HOLDER soa, size_t index) :                                                                                \
+      soa_(soa),                                                                                                                    \
+      index_(index)                                                                                                                 \
+    { }                                                                                                                             \
+                                                                                                                                    \
+    SOA_HOST_DEVICE                                                                                                                 \
+    element_type& operator=(element_type const& other) {                                                                            \
+      _DECLARE_SOA_ELEMENT_ASSIGNMENTS(__VA_ARGS__)                                                                                 \
+      return *this;                                                                                                                 \
+    }                                                                                                                               \
+                                                                                                                                    \
+    SOA_HOST_DEVICE                                                                                                                 \
+    element_type& operator=(element_type && other) {                                                                                \
+      _DECLARE_SOA_ELEMENT_ASSIGNMENTS(__VA_ARGS__)                                                                                 \
+      return *this;                                                                                                                 \
+    }                                                                                                                               \
+                                                                                                                                    \
+    SOA_HOST_DEVICE                                                                                                                 \
+    element_type& operator=(const_element const& other) {                                                                           \
+      _DECLARE_SOA_ELEMENT_ASSIGNMENTS(__VA_ARGS__)                                                                                 \
+      return *this;                                                                                                                 \
+    }                                                                                                                               \
+                                                                                                                                    \
+    SOA_HOST_DEVICE                                                                                                                 \
+    element_type& operator=(const_element && other) {                                                                               \
+      _DECLARE_SOA_ELEMENT_ASSIGNMENTS(__VA_ARGS__)                                                                                 \
       return *this;                                                                                                                 \
     }                                                                                                                               \
                                                                                                                                     \
+    SOA_HOST_DEVICE                                                                                                                 \
+    operator const_element() const {                                                                                                \
+      return const_element(soa_, index_);                                                                                           \
+    }                                                                                                                               \
+                                                                                                                                    \
+    SOA_HOST_DEVICE                                                                                                                 \
+    element_type& operator=(value_type const& other) {                                                                              \
+      _DECLARE_SOA_ELEMENT_VALUE_ASSIGNMENTS(__VA_ARGS__)                                                                           \
+      return *this;                                                                                                                 \
+    }                                                                                                                               \
+                                                                                                                                    \
+    SOA_HOST_DEVICE                                                                                                                 \
+    operator value_type() const {                                                                                                   \
+      value_type result;                                                                                                            \
+      _DECLARE_SOA_ELEMENT_VALUE_CONVERSIONS(__VA_ARGS__)                                                                           \
+      return result;                                                                                                                \
+    }                                                                                                                               \
+                                                                                                                                    \
+    /* swap the values of two elements, e.g. for std::iter_swap() and std::sort() */                                                \
+    SOA_HOST_DEVICE                                                                                                                 \
+    friend void swap(element_type a, element_type b) {                                                                              \
+      value_type tmp = a;                                                                                                           \
+      a = b;                                                                                                                        \
+      b = tmp;                                                                                                                      \
+    }                                                                                                                               \
+                                                                                                                                    \
     _DECLARE_SOA_ELEMENT_ACCESSORS(__VA_ARGS__)                                                                                     \
                                                                                                                                     \
   private:                                                                                                                          \
-    CLASS & soa_;                                                                                                                   \
+    ELEMENT_HOLDER soa_;                                                                                                            \
+    const size_t index_;                                                                                                            \
+  };                                                                                                                                \
+                                                                                                                                    \
+  using element = element_type<>;
+
+
+/* dump SoA fields information, for the field I; these should expand to, for columns:
+ *
+ *   std::cout << "  x_[" << SoA::size << "] at "
+ *             << SoA::offsets_[I] << " has size " << soa_detail::field_extent(SoA::fields[I], SoA::size) << std::endl;
+ *
+ * and for scalars:
+ *
+ *   std::cout << "  x_ at "
+ *             << SoA::offsets_[I] << " has size " << soa_detail::field_extent(SoA::fields[I], SoA::size) << std::endl;
+ *
+ */
+
+#define _DECLARE_SOA_DUMP_INFO_IMPL(I, IS_COLUMN, TYPE, NAME)                                                                       \
+  BOOST_PP_IIF(IS_COLUMN,                                                                                                           \
+    std::cout << "  " BOOST_PP_STRINGIZE(NAME) "_[" << SoA::size << "] at "                                                         \
+              << SoA::offsets_[I] << " has size " << soa_detail::field_extent(SoA::fields[I], SoA::size) << std::endl;              \
+  ,                                                                                                                                 \
+    std::cout << "  " BOOST_PP_STRINGIZE(NAME) "_ at "                                                                              \
+              << SoA::offsets_[I] << " has size " << soa_detail::field_extent(SoA::fields[I], SoA::size) << std::endl;              \
+  )
+
+#define _DECLARE_SOA_DUMP_INFO(R, DATA, I, TYPE_NAME)                                                                               \
+  BOOST_PP_EXPAND(_DECLARE_SOA_DUMP_INFO_IMPL BOOST_PP_TUPLE_PUSH_FRONT(TYPE_NAME, I))
+
+#define _DECLARE_SOA_DUMP_INFOS(...)                                                                                                \
+  BOOST_PP_SEQ_FOR_EACH_I(_DECLARE_SOA_DUMP_INFO, ~, BOOST_PP_VARIADIC_TO_SEQ(__VA_ARGS__))
+
+
+#define declare_SoA_template(CLASS, ...)                                                                                            \
+                                                                                                                                    \
+/* struct type with value semantics, corresponding to an individual element of a SoA */                                             \
+struct BOOST_PP_CAT(CLASS, Entry) {                                                                                                 \
+  _DECLARE_SOA_VALUE_MEMBERS(__VA_ARGS__)                                                                                           \
+};                                                                                                                                  \
+                                                                                                                                    \
+template <size_t SIZE, size_t ALIGN, typename ORDER>                                                                                \
+struct CLASS;                                                                                                                       \
+/* names of the fields, in declaration order */                                                                                     \
+enum class BOOST_PP_CAT(CLASS, Field) : size_t {                                                                                    \
+  _DECLARE_SOA_FIELD_ENUMERATORS(__VA_ARGS__)                                                                                       \
+};                                                                                                                                  \
+                                                                                                                                    \
+struct BOOST_PP_CAT(CLASS, ConstView);                                                                                              \
+template <typename VIEW, BOOST_PP_CAT(CLASS, Field)... FIELDS>                                                                      \
+struct BOOST_PP_CAT(CLASS, Projection);                                                                                             \
+                                                                                                                                    \
+/* non-owning view over the elements of a SoA, trivially copyable */                                                                \
+struct BOOST_PP_CAT(CLASS, View) {                                                                                                  \
+                                                                                                                                    \
+  using self_type = BOOST_PP_CAT(CLASS, View);                                                                                      \
+  using const_view_type = BOOST_PP_CAT(CLASS, ConstView);                                                                           \
+                                                                                                                                    \
+  /* description of the fields, in declaration order */                                                                             \
+  static constexpr soa_field_info fields[] = {                                                                                      \
+    _DECLARE_SOA_FIELD_INFOS(__VA_ARGS__)                                                                                           \
+  };                                                                                                                                \
+                                                                                                                                    \
+  /* an empty view */                                                                                                               \
+  BOOST_PP_CAT(CLASS, View)() = default;                                                                                            \
+                                                                                                                                    \
+  /* AoS-like accessor to individual elements */                                                                                    \
+  using value_type = BOOST_PP_CAT(CLASS, Entry);                                                                                    \
+  _DECLARE_SOA_ELEMENT_TYPES(BOOST_PP_CAT(CLASS, View) const, BOOST_PP_CAT(CLASS, View) const, __VA_ARGS__)                         \
+                                                                                                                                    \
+  /* AoS-like accessor */                                                                                                           \
+  SOA_HOST_DEVICE                                                                                                                   \
+  element operator[](size_t index) const { return element(*this, index); }                                                          \
+                                                                                                                                    \
+  /* iterators over the elements */                                                                                                 \
+  using iterator = soa_iterator<BOOST_PP_CAT(CLASS, View), element>;                                                                \
+  using const_iterator = soa_iterator<BOOST_PP_CAT(CLASS, View), const_element>;                                                    \
+                                                                                                                                    \
+  SOA_HOST_DEVICE iterator begin() const { return iterator(*this, 0); }                                                             \
+  SOA_HOST_DEVICE iterator end() const { return iterator(*this, size_); }                                                           \
+  SOA_HOST_DEVICE const_iterator cbegin() const { return const_iterator(*this, 0); }                                                \
+  SOA_HOST_DEVICE const_iterator cend() const { return const_iterator(*this, size_); }                                              \
+                                                                                                                                    \
+  /* number of elements */                                                                                                          \
+  SOA_HOST_DEVICE                                                                                                                   \
+  size_t size() const { return size_; }                                                                                             \
+                                                                                                                                    \
+  /* view over the elements [offset, offset + count) */                                                                             \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, View) subspan(size_t offset, size_t count) const {                                                            \
+    assert(offset + count <= size_);                                                                                                \
+    BOOST_PP_CAT(CLASS, View) result = *this;                                                                                       \
+    result.size_ = count;                                                                                                           \
+    _DECLARE_SOA_VIEW_OFFSETS(__VA_ARGS__)                                                                                          \
+    return result;                                                                                                                  \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, View) view() const { return *this; }                                                                          \
+                                                                                                                                    \
+  /* copy the first `count` elements from an array of structures with data members named after the columns, such as */              \
+  /* value_type; the elements are converted in blocks of soa_aos_block_size, one column at a time */                                \
+  template <typename T>                                                                                                             \
+  SOA_HOST_DEVICE                                                                                                                   \
+  void from_aos(T const* data, size_t count) const {                                                                                \
+    assert(count <= size_);                                                                                                         \
+    for (size_t first = 0; first < count; first += soa_aos_block_size) {                                                            \
+      size_t last = std::min(count, first + soa_aos_block_size);                                                                    \
+      _DECLARE_SOA_VIEW_FROM_AOSS(__VA_ARGS__)                                                                                      \
+    }                                                                                                                               \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* copy the first `count` elements to an array of structures with data members named after the columns, such as */                \
+  /* value_type; the elements are converted in blocks of soa_aos_block_size, one column at a time */                                \
+  template <typename T>                                                                                                             \
+  SOA_HOST_DEVICE                                                                                                                   \
+  void to_aos(T* data, size_t count) const {                                                                                        \
+    assert(count <= size_);                                                                                                         \
+    for (size_t first = 0; first < count; first += soa_aos_block_size) {                                                            \
+      size_t last = std::min(count, first + soa_aos_block_size);                                                                    \
+      _DECLARE_SOA_VIEW_TO_AOSS(__VA_ARGS__)                                                                                        \
+    }                                                                                                                               \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* accessors */                                                                                                                   \
+  _DECLARE_SOA_VIEW_ACCESSORS(, __VA_ARGS__)                                                                                        \
+                                                                                                                                    \
+  /* projection over the given fields only, e.g. select<SoAField::x, SoAField::y>() */                                              \
+  template <BOOST_PP_CAT(CLASS, Field)... FIELDS>                                                                                   \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, Projection)<self_type, FIELDS...> select() const {                                                            \
+    return BOOST_PP_CAT(CLASS, Projection)<self_type, FIELDS...>(*this);                                                            \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* tuples of pointers to the columns and to the scalars, in declaration order */                                                  \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto columns() const { return std::tuple_cat(std::tuple<>() _DECLARE_SOA_COLUMN_TUPLE(__VA_ARGS__)); }                            \
+                                                                                                                                    \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto scalars() const { return std::tuple_cat(std::tuple<>() _DECLARE_SOA_SCALAR_TUPLE(__VA_ARGS__)); }                            \
+                                                                                                                                    \
+  /* tuple of pointers to all the fields, in declaration order */                                                                   \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto pointers() const { return std::tuple_cat(std::tuple<>() _DECLARE_SOA_FIELD_TUPLE(__VA_ARGS__)); }                            \
+                                                                                                                                    \
+protected:                                                                                                                          \
+  template <size_t, size_t, typename> friend struct CLASS;                                                                          \
+  friend struct BOOST_PP_CAT(CLASS, ConstView);                                                                                     \
+                                                                                                                                    \
+  size_t size_ = 0;                                                                                                                 \
+                                                                                                                                    \
+  /* pointers to the data */                                                                                                        \
+  _DECLARE_SOA_VIEW_MEMBERS(, __VA_ARGS__)                                                                                          \
+};                                                                                                                                  \
+                                                                                                                                    \
+static_assert(std::is_trivially_copyable_v<BOOST_PP_CAT(CLASS, View)>);                                                             \
+                                                                                                                                    \
+/* non-owning read-only view over the elements of a SoA, trivially copyable */                                                      \
+struct BOOST_PP_CAT(CLASS, ConstView) {                                                                                             \
+                                                                                                                                    \
+  using self_type = BOOST_PP_CAT(CLASS, ConstView);                                                                                 \
+                                                                                                                                    \
+  /* description of the fields, in declaration order */                                                                             \
+  static constexpr auto const& fields = BOOST_PP_CAT(CLASS, View)::fields;                                                          \
+                                                                                                                                    \
+  /* an empty view */                                                                                                               \
+  BOOST_PP_CAT(CLASS, ConstView)() = default;                                                                                       \
+                                                                                                                                    \
+  /* read-only view over the same elements as a read-write one */                                                                   \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, ConstView)(BOOST_PP_CAT(CLASS, View) const& other) :                                                          \
+    size_(other.size_)                                                                                                              \
+  {                                                                                                                                 \
+    _DECLARE_SOA_VIEW_COPIES(__VA_ARGS__)                                                                                           \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* AoS-like accessor to individual elements */                                                                                    \
+  using value_type = BOOST_PP_CAT(CLASS, Entry);                                                                                    \
+  _DECLARE_SOA_CONST_ELEMENT_TYPE(BOOST_PP_CAT(CLASS, ConstView) const, __VA_ARGS__)                                                \
+                                                                                                                                    \
+  /* AoS-like accessor */                                                                                                           \
+  SOA_HOST_DEVICE                                                                                                                   \
+  const_element operator[](size_t index) const { return const_element(*this, index); }                                              \
+                                                                                                                                    \
+  /* iterators over the elements */                                                                                                 \
+  using iterator = soa_iterator<BOOST_PP_CAT(CLASS, ConstView), const_element>;                                                     \
+  using const_iterator = iterator;                                                                                                  \
+                                                                                                                                    \
+  SOA_HOST_DEVICE iterator begin() const { return iterator(*this, 0); }                                                             \
+  SOA_HOST_DEVICE iterator end() const { return iterator(*this, size_); }                                                           \
+  SOA_HOST_DEVICE const_iterator cbegin() const { return const_iterator(*this, 0); }                                                \
+  SOA_HOST_DEVICE const_iterator cend() const { return const_iterator(*this, size_); }                                              \
+                                                                                                                                    \
+  /* number of elements */                                                                                                          \
+  SOA_HOST_DEVICE                                                                                                                   \
+  size_t size() const { return size_; }                                                                                             \
+                                                                                                                                    \
+  /* view over the elements [offset, offset + count) */                                                                             \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, ConstView) subspan(size_t offset, size_t count) const {                                                       \
+    assert(offset + count <= size_);                                                                                                \
+    BOOST_PP_CAT(CLASS, ConstView) result = *this;                                                                                  \
+    result.size_ = count;                                                                                                           \
+    _DECLARE_SOA_VIEW_OFFSETS(__VA_ARGS__)                                                                                          \
+    return result;                                                                                                                  \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, ConstView) view() const { return *this; }                                                                     \
+                                                                                                                                    \
+  /* copy the first `count` elements to an array of structures with data members named after the columns, such as */                \
+  /* value_type; the elements are converted in blocks of soa_aos_block_size, one column at a time */                                \
+  template <typename T>                                                                                                             \
+  SOA_HOST_DEVICE                                                                                                                   \
+  void to_aos(T* data, size_t count) const {                                                                                        \
+    assert(count <= size_);                                                                                                         \
+    for (size_t first = 0; first < count; first += soa_aos_block_size) {                                                            \
+      size_t last = std::min(count, first + soa_aos_block_size);                                                                    \
+      _DECLARE_SOA_VIEW_TO_AOSS(__VA_ARGS__)                                                                                        \
+    }                                                                                                                               \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* accessors */                                                                                                                   \
+  _DECLARE_SOA_VIEW_ACCESSORS(const, __VA_ARGS__)                                                                                   \
+                                                                                                                                    \
+  /* projection over the given fields only, e.g. select<SoAField::x, SoAField::y>() */                                              \
+  template <BOOST_PP_CAT(CLASS, Field)... FIELDS>                                                                                   \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, Projection)<self_type, FIELDS...> select() const {                                                            \
+    return BOOST_PP_CAT(CLASS, Projection)<self_type, FIELDS...>(*this);                                                            \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* tuples of pointers to the columns and to the scalars, in declaration order */                                                  \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto columns() const { return std::tuple_cat(std::tuple<>() _DECLARE_SOA_COLUMN_TUPLE(__VA_ARGS__)); }                            \
+                                                                                                                                    \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto scalars() const { return std::tuple_cat(std::tuple<>() _DECLARE_SOA_SCALAR_TUPLE(__VA_ARGS__)); }                            \
+                                                                                                                                    \
+  /* tuple of pointers to all the fields, in declaration order */                                                                   \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto pointers() const { return std::tuple_cat(std::tuple<>() _DECLARE_SOA_FIELD_TUPLE(__VA_ARGS__)); }                            \
+                                                                                                                                    \
+protected:                                                                                                                          \
+  template <size_t, size_t, typename> friend struct CLASS;                                                                          \
+                                                                                                                                    \
+  size_t size_ = 0;                                                                                                                 \
+                                                                                                                                    \
+  /* pointers to the data */                                                                                                        \
+  _DECLARE_SOA_VIEW_MEMBERS(const, __VA_ARGS__)                                                                                     \
+};                                                                                                                                  \
+                                                                                                                                    \
+static_assert(std::is_trivially_copyable_v<BOOST_PP_CAT(CLASS, ConstView)>);                                                        \
+                                                                                                                                    \
+/* non-owning view over the FIELDS of a VIEW (CLASS##View or CLASS##ConstView): its elements only access, and copy, the             \
+ * selected fields */                                                                                                               \
+template <typename VIEW, BOOST_PP_CAT(CLASS, Field)... FIELDS>                                                                      \
+struct BOOST_PP_CAT(CLASS, Projection) {                                                                                            \
+                                                                                                                                    \
+  using self_type = BOOST_PP_CAT(CLASS, Projection);                                                                                \
+  using view_type = VIEW;                                                                                                           \
+  using field_type = BOOST_PP_CAT(CLASS, Field);                                                                                    \
+                                                                                                                                    \
+  /* description of all the fields, in declaration order */                                                                         \
+  static constexpr auto const& fields = BOOST_PP_CAT(CLASS, View)::fields;                                                          \
+                                                                                                                                    \
+  /* position of FIELD among the selected fields, or the number of selected fields if it is not selected */                         \
+  template <field_type FIELD>                                                                                                       \
+  static constexpr size_t index() {                                                                                                 \
+    constexpr field_type selected[] = { FIELDS... };                                                                                \
+    size_t i = 0;                                                                                                                   \
+    while (i < sizeof...(FIELDS) and selected[i] != FIELD)                                                                          \
+      ++i;                                                                                                                          \
+    return i;                                                                                                                       \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  template <field_type FIELD>                                                                                                       \
+  static constexpr bool contains() { return index<FIELD>() < sizeof...(FIELDS); }                                                   \
+                                                                                                                                    \
+  /* an empty projection */                                                                                                         \
+  BOOST_PP_CAT(CLASS, Projection)() = default;                                                                                      \
+                                                                                                                                    \
+  SOA_HOST_DEVICE                                                                                                                   \
+  explicit BOOST_PP_CAT(CLASS, Projection)(VIEW const& view) :                                                                      \
+    size_(view.size()),                                                                                                             \
+    pointers_(std::get<static_cast<size_t>(FIELDS)>(view.pointers())...)                                                            \
+  { }                                                                                                                               \
+                                                                                                                                    \
+  /* AoS-like accessor to the selected fields of individual elements, holding a copy of the projection; copying an element          \
+   * copies only the selected columns */                                                                                            \
+  struct element {                                                                                                                  \
+    SOA_HOST_DEVICE                                                                                                                 \
+    element(BOOST_PP_CAT(CLASS, Projection) const& soa, size_t index) :                                                             \
+      soa_(soa),                                                                                                                    \
+      index_(index)                                                                                                                 \
+    { }                                                                                                                             \
+                                                                                                                                    \
+    SOA_HOST_DEVICE                                                                                                                 \
+    element& operator=(element const& other) {                                                                                      \
+      (assign<FIELDS>(other), ...);                                                                                                 \
+      return *this;                                                                                                                 \
+    }                                                                                                                               \
+                                                                                                                                    \
+    _DECLARE_SOA_PROJECTION_ELEMENT_ACCESSORS(__VA_ARGS__)                                                                          \
+                                                                                                                                    \
+  private:                                                                                                                          \
+    template <field_type FIELD>                                                                                                     \
+    SOA_HOST_DEVICE                                                                                                                 \
+    void assign(element const& other) {                                                                                             \
+      if constexpr (fields[static_cast<size_t>(FIELD)].is_column)                                                                   \
+        soa_.template get<FIELD>()[index_] = other.soa_.template get<FIELD>()[other.index_];                                        \
+    }                                                                                                                               \
+                                                                                                                                    \
+    BOOST_PP_CAT(CLASS, Projection) const soa_;                                                                                     \
     const size_t index_;                                                                                                            \
   };                                                                                                                                \
                                                                                                                                     \
+  SOA_HOST_DEVICE                                                                                                                   \
+  element operator[](size_t index) const { return element(*this, index); }                                                          \
+                                                                                                                                    \
+  /* number of elements */                                                                                                          \
+  SOA_HOST_DEVICE                                                                                                                   \
+  size_t size() const { return size_; }                                                                                             \
+                                                                                                                                    \
+  /* projection over the elements [offset, offset + count) */                                                                       \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, Projection) subspan(size_t offset, size_t count) const {                                                      \
+    assert(offset + count <= size_);                                                                                                \
+    BOOST_PP_CAT(CLASS, Projection) result = *this;                                                                                 \
+    result.size_ = count;                                                                                                           \
+    (result.template advance<FIELDS>(offset), ...);                                                                                 \
+    return result;                                                                                                                  \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, Projection) view() const { return *this; }                                                                    \
+                                                                                                                                    \
+  /* pointer to a selected field */                                                                                                 \
+  template <field_type FIELD>                                                                                                       \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto get() const {                                                                                                                \
+    static_assert(contains<FIELD>(), "the field is not part of the projection");                                                    \
+    return std::get<index<FIELD>()>(pointers_);                                                                                     \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* accessors, valid only for the selected fields */                                                                               \
+  _DECLARE_SOA_PROJECTION_ACCESSORS(CLASS, __VA_ARGS__)                                                                             \
+                                                                                                                                    \
+  /* tuples of pointers to the selected columns and to the selected scalars, in the order they were selected */                     \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto columns() const { return std::tuple_cat(std::tuple<>(), select_if<FIELDS, true>()...); }                                     \
+                                                                                                                                    \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto scalars() const { return std::tuple_cat(std::tuple<>(), select_if<FIELDS, false>()...); }                                    \
+                                                                                                                                    \
+private:                                                                                                                            \
+  template <field_type FIELD>                                                                                                       \
+  SOA_HOST_DEVICE                                                                                                                   \
+  void advance(size_t offset) {                                                                                                     \
+    if constexpr (fields[static_cast<size_t>(FIELD)].is_column)                                                                     \
+      std::get<index<FIELD>()>(pointers_) += offset;                                                                                \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* a tuple with the pointer to FIELD if it is a column (or a scalar), or an empty tuple */                                        \
+  template <field_type FIELD, bool IS_COLUMN>                                                                                       \
+  SOA_HOST_DEVICE                                                                                                                   \
+  auto select_if() const {                                                                                                          \
+    if constexpr (fields[static_cast<size_t>(FIELD)].is_column == IS_COLUMN)                                                        \
+      return std::make_tuple(get<FIELD>());                                                                                         \
+    else                                                                                                                            \
+      return std::tuple<>();                                                                                                        \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  size_t size_ = 0;                                                                                                                 \
+  std::tuple<std::tuple_element_t<static_cast<size_t>(FIELDS), decltype(std::declval<VIEW>().pointers())>...> pointers_;            \
+};                                                                                                                                  \
+                                                                                                                                    \
+template <size_t SIZE, size_t ALIGN=0, typename ORDER=soa_declaration_order>                                                        \
+struct CLASS {                                                                                                                      \
+                                                                                                                                    \
+  /* these could be moved to an external type trait to free up the symbol names */                                                  \
+  using self_type = CLASS;                                                                                                          \
+  static const size_t size = SIZE;                                                                                                  \
+  static const size_t alignment = ALIGN;                                                                                            \
+  using order_policy = ORDER;                                                                                                       \
+                                                                                                                                    \
+  /* description of the fields, in declaration order */                                                                             \
+  static constexpr auto const& fields = BOOST_PP_CAT(CLASS, View)::fields;                                                          \
+                                                                                                                                    \
+  /* AoS-like accessor to individual elements */                                                                                    \
+  using value_type = BOOST_PP_CAT(CLASS, Entry);                                                                                    \
+  _DECLARE_SOA_ELEMENT_TYPES(CLASS const &, CLASS &, __VA_ARGS__)                                                                   \
+                                                                                                                                    \
   /* AoS-like accessor */                                                                                                           \
   SOA_HOST_DEVICE                                                                                                                   \
   element operator[](size_t index) { return element(*this, index); }                                                                \
                                                                                                                                     \
+  SOA_HOST_DEVICE                                                                                                                   \
+  const_element operator[](size_t index) const { return const_element(*this, index); }                                              \
+                                                                                                                                    \
+  /* iterators over the elements */                                                                                                 \
+  using iterator = soa_iterator<CLASS *, element>;                                                                                  \
+  using const_iterator = soa_iterator<CLASS const *, const_element>;                                                                \
+                                                                                                                                    \
+  SOA_HOST_DEVICE iterator begin() { return iterator(this, 0); }                                                                    \
+  SOA_HOST_DEVICE iterator end() { return iterator(this, SIZE); }                                                                   \
+  SOA_HOST_DEVICE const_iterator begin() const { return const_iterator(this, 0); }                                                  \
+  SOA_HOST_DEVICE const_iterator end() const { return const_iterator(this, SIZE); }                                                 \
+  SOA_HOST_DEVICE const_iterator cbegin() const { return const_iterator(this, 0); }                                                 \
+  SOA_HOST_DEVICE const_iterator cend() const { return const_iterator(this, SIZE); }                                                \
+                                                                                                                                    \
   /* accessors */                                                                                                                   \
   _DECLARE_SOA_ACCESSORS(__VA_ARGS__)                                                                                               \
   _DECLARE_SOA_CONST_ACCESSORS(__VA_ARGS__)                                                                                         \
                                                                                                                                     \
+  /* non-owning views over all the elements */                                                                                      \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, View) view() {                                                                                                \
+    BOOST_PP_CAT(CLASS, View) result;                                                                                               \
+    result.size_ = SIZE;                                                                                                            \
+    _DECLARE_SOA_VIEW_FROM_DATA_MEMBERS(__VA_ARGS__)                                                                                \
+    return result;                                                                                                                  \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, ConstView) view() const {                                                                                     \
+    BOOST_PP_CAT(CLASS, ConstView) result;                                                                                          \
+    result.size_ = SIZE;                                                                                                            \
+    _DECLARE_SOA_VIEW_FROM_DATA_MEMBERS(__VA_ARGS__)                                                                                \
+    return result;                                                                                                                  \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* conversion from and to an array of structures, see the corresponding view methods */                                           \
+  template <typename T>                                                                                                             \
+  SOA_HOST_DEVICE                                                                                                                   \
+  void from_aos(T const* data, size_t count) { view().from_aos(data, count); }                                                      \
+                                                                                                                                    \
+  template <typename T>                                                                                                             \
+  SOA_HOST_DEVICE                                                                                                                   \
+  void to_aos(T* data, size_t count) const { view().to_aos(data, count); }                                                          \
+                                                                                                                                    \
+  /* projection over the given fields only, see the corresponding view method */                                                    \
+  template <BOOST_PP_CAT(CLASS, Field)... FIELDS>                                                                                   \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, Projection)<BOOST_PP_CAT(CLASS, View), FIELDS...> select() {                                                  \
+    return view().template select<FIELDS...>();                                                                                     \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  template <BOOST_PP_CAT(CLASS, Field)... FIELDS>                                                                                   \
+  SOA_HOST_DEVICE                                                                                                                   \
+  BOOST_PP_CAT(CLASS, Projection)<BOOST_PP_CAT(CLASS, ConstView), FIELDS...> select() const {                                       \
+    return view().template select<FIELDS...>();                                                                                     \
+  }                                                                                                                                 \
+                                                                                                                                    \
   /* dump the SoA internal structure */                                                                                             \
   template <typename T> SOA_HOST_ONLY friend void dump();                                                                           \
                                                                                                                                     \
 private:                                                                                                                            \
+  /* offsets of the fields inside buffer_, in declaration order, followed by its size; the fields are placed in the order           \
+   * given by the ORDER policy, as in a runtime sized layout */                                                                     \
+  static constexpr std::array<size_t, std::size(fields) + 1> offsets_ =                                                             \
+    soa_detail::field_offsets(fields, SIZE, ALIGN, ORDER::order(fields, SIZE, ALIGN));                                              \
+                                                                                                                                    \
   /* data members */                                                                                                                \
-  _DECLARE_SOA_DATA_MEMBERS(__VA_ARGS__)                                                                                            \
+  alignas(soa_detail::buffer_alignment(fields, ALIGN)) std::byte buffer_[offsets_.back()];                                          \
+};                                                                                                                                  \
+                                                                                                                                    \
+/* runtime sized SoA, with all the fields placed inside a single caller-provided buffer, in the order given by the ORDER policy */  \
+template <size_t ALIGN=0, typename ORDER=soa_declaration_order>                                                                     \
+struct BOOST_PP_CAT(CLASS, Layout) : public BOOST_PP_CAT(CLASS, View) {                                                             \
+                                                                                                                                    \
+  using self_type = BOOST_PP_CAT(CLASS, Layout);                                                                                    \
+  static const size_t alignment = ALIGN;                                                                                            \
+  using order_policy = ORDER;                                                                                                       \
+                                                                                                                                    \
+  /* alignment required for the buffer */                                                                                           \
+  static constexpr size_t buffer_alignment = soa_detail::buffer_alignment(fields, ALIGN);                                           \
+                                                                                                                                    \
+  /* offsets of the fields inside the buffer, followed by the total buffer size */                                                  \
+  static constexpr                                                                                                                  \
+  std::array<size_t, std::size(fields) + 1> compute_offsets(size_t elements) {                                                      \
+    return soa_detail::field_offsets(fields, elements, ALIGN, ORDER::order(fields, elements, ALIGN));                               \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* size in bytes of the buffer required to hold a SoA with the given number of elements */                                        \
+  static constexpr                                                                                                                  \
+  size_t compute_data_size(size_t elements) {                                                                                       \
+    return compute_offsets(elements).back();                                                                                        \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* the buffer must be aligned to buffer_alignment, and at least compute_data_size(elements) bytes long */                         \
+  BOOST_PP_CAT(CLASS, Layout)(std::byte* buffer, size_t elements) :                                                                 \
+    buffer_(buffer)                                                                                                                 \
+  {                                                                                                                                 \
+    assert(reinterpret_cast<uintptr_t>(buffer) % buffer_alignment == 0);                                                            \
+    auto offsets = compute_offsets(elements);                                                                                       \
+    size_ = elements;                                                                                                               \
+    _DECLARE_SOA_VIEW_FROM_BUFFERS(__VA_ARGS__)                                                                                     \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* underlying buffer */                                                                                                           \
+  SOA_HOST_DEVICE                                                                                                                   \
+  std::byte* buffer() const { return buffer_; }                                                                                     \
+                                                                                                                                    \
+private:                                                                                                                            \
+  std::byte* buffer_;                                                                                                               \
+};                                                                                                                                  \
+                                                                                                                                    \
+/* growable SoA, with all the fields in a single buffer owned by the SoA and allocated by ALLOCATOR: when the SoA grows,            \
+ * all the columns are moved together to a new buffer; the fields must be trivially copyable */                                     \
+template <size_t ALIGN=0, typename ALLOCATOR=soa_aligned_allocator>                                                                 \
+struct BOOST_PP_CAT(CLASS, Vector) : public BOOST_PP_CAT(CLASS, View) {                                                             \
+                                                                                                                                    \
+  using self_type = BOOST_PP_CAT(CLASS, Vector);                                                                                    \
+  using allocator_type = ALLOCATOR;                                                                                                 \
+  static const size_t alignment = ALIGN;                                                                                            \
+                                                                                                                                    \
+  /* the fields are moved to a new buffer with memcpy */                                                                            \
+  _DECLARE_SOA_TRIVIALLY_COPYABLES(__VA_ARGS__)                                                                                     \
+                                                                                                                                    \
+  /* alignment of the buffer */                                                                                                     \
+  static constexpr size_t buffer_alignment = soa_detail::buffer_alignment(fields, ALIGN);                                           \
+                                                                                                                                    \
+  /* offsets of the fields inside the buffer, followed by the total buffer size */                                                  \
+  static constexpr                                                                                                                  \
+  std::array<size_t, std::size(fields) + 1> compute_offsets(size_t elements) {                                                      \
+    return soa_detail::field_offsets(fields, elements, ALIGN, soa_declaration_order::order(fields, elements, ALIGN));               \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* size in bytes of the buffer required to hold the given number of elements */                                                   \
+  static constexpr                                                                                                                  \
+  size_t compute_data_size(size_t elements) {                                                                                       \
+    return compute_offsets(elements).back();                                                                                        \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* an empty SoA; the scalars are always allocated */                                                                              \
+  explicit BOOST_PP_CAT(CLASS, Vector)(ALLOCATOR const& allocator = ALLOCATOR()) :                                                  \
+    allocator_(allocator)                                                                                                           \
+  {                                                                                                                                 \
+    reallocate(0);                                                                                                                  \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* a SoA with `elements` value-initialised elements */                                                                            \
+  explicit BOOST_PP_CAT(CLASS, Vector)(size_t elements, ALLOCATOR const& allocator = ALLOCATOR()) :                                 \
+    allocator_(allocator)                                                                                                           \
+  {                                                                                                                                 \
+    reallocate(elements);                                                                                                           \
+    resize(elements);                                                                                                               \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  BOOST_PP_CAT(CLASS, Vector)(BOOST_PP_CAT(CLASS, Vector) const& other) :                                                           \
+    allocator_(other.allocator_)                                                                                                    \
+  {                                                                                                                                 \
+    reallocate(other.size_);                                                                                                        \
+    if (other.buffer_)                                                                                                              \
+      soa_detail::copy_fields(fields, other.size_, other.buffer_, other.compute_offsets(other.capacity_), buffer_,                  \
+                              compute_offsets(capacity_));                                                                          \
+    size_ = other.size_;                                                                                                            \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* leave the other SoA empty, without a buffer: its scalars are allocated again, value-initialised, by the next call to           \
+   * reserve(), resize() or push_back() */                                                                                          \
+  BOOST_PP_CAT(CLASS, Vector)(BOOST_PP_CAT(CLASS, Vector) && other)                                                                 \
+      noexcept(std::is_nothrow_move_constructible_v<ALLOCATOR>) :                                                                   \
+    BOOST_PP_CAT(CLASS, View)(std::exchange(static_cast<BOOST_PP_CAT(CLASS, View)&>(other), BOOST_PP_CAT(CLASS, View)())),          \
+    allocator_(std::move(other.allocator_)),                                                                                        \
+    buffer_(std::exchange(other.buffer_, nullptr)),                                                                                 \
+    capacity_(std::exchange(other.capacity_, 0))                                                                                    \
+  { }                                                                                                                               \
+                                                                                                                                    \
+  BOOST_PP_CAT(CLASS, Vector)& operator=(BOOST_PP_CAT(CLASS, Vector) other) {                                                       \
+    swap(other);                                                                                                                    \
+    return *this;                                                                                                                   \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  ~BOOST_PP_CAT(CLASS, Vector)() {                                                                                                  \
+    if (buffer_)                                                                                                                    \
+      allocator_.deallocate(buffer_, compute_data_size(capacity_), buffer_alignment);                                               \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  void swap(BOOST_PP_CAT(CLASS, Vector)& other) {                                                                                   \
+    std::swap(static_cast<BOOST_PP_CAT(CLASS, View)&>(*this), static_cast<BOOST_PP_CAT(CLASS, View)&>(other));                      \
+    std::swap(allocator_, other.allocator_);                                                                                        \
+    std::swap(buffer_, other.buffer_);                                                                                              \
+    std::swap(capacity_, other.capacity_);                                                                                          \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* number of elements that can be held without reallocating the buffer */                                                         \
+  size_t capacity() const { return capacity_; }                                                                                     \
+                                                                                                                                    \
+  bool empty() const { return size_ == 0; }                                                                                         \
+                                                                                                                                    \
+  /* make room for at least `elements` elements */                                                                                  \
+  void reserve(size_t elements) {                                                                                                   \
+    if (elements > capacity_ or not buffer_)                                                                                        \
+      reallocate(elements);                                                                                                         \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* change the number of elements; the new elements are value-initialised */                                                       \
+  void resize(size_t elements) {                                                                                                    \
+    reserve(elements);                                                                                                              \
+    if (elements > size_)                                                                                                           \
+      soa_detail::zero_columns(fields, size_, elements, buffer_, compute_offsets(capacity_));                                       \
+    size_ = elements;                                                                                                               \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  void clear() { size_ = 0; }                                                                                                       \
+                                                                                                                                    \
+  /* release the unused capacity */                                                                                                 \
+  void shrink_to_fit() {                                                                                                            \
+    if (capacity_ > size_)                                                                                                          \
+      reallocate(size_);                                                                                                            \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* append an element, growing the buffer geometrically */                                                                         \
+  element push_back(value_type const& value) {                                                                                      \
+    if (size_ == capacity_)                                                                                                         \
+      reallocate(std::max<size_t>(2 * capacity_, min_capacity));                                                                    \
+    (*this)[size_] = value;                                                                                                         \
+    return (*this)[size_++];                                                                                                        \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* append an element with the given values of the columns, in declaration order */                                                \
+  template <typename... ARGS>                                                                                                       \
+  element emplace_back(ARGS&&... args) {                                                                                            \
+    return push_back(value_type{ std::forward<ARGS>(args)... });                                                                    \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  void pop_back() {                                                                                                                 \
+    assert(size_ > 0);                                                                                                              \
+    --size_;                                                                                                                        \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* projection over the given fields only, see the corresponding view method; it is read-only for a const SoA */                   \
+  template <BOOST_PP_CAT(CLASS, Field)... FIELDS>                                                                                   \
+  BOOST_PP_CAT(CLASS, Projection)<BOOST_PP_CAT(CLASS, View), FIELDS...> select() {                                                  \
+    return view().template select<FIELDS...>();                                                                                     \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  template <BOOST_PP_CAT(CLASS, Field)... FIELDS>                                                                                   \
+  BOOST_PP_CAT(CLASS, Projection)<BOOST_PP_CAT(CLASS, ConstView), FIELDS...> select() const {                                       \
+    return BOOST_PP_CAT(CLASS, ConstView)(view()).template select<FIELDS...>();                                                     \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* underlying buffer */                                                                                                           \
+  std::byte* buffer() const { return buffer_; }                                                                                     \
+                                                                                                                                    \
+private:                                                                                                                            \
+  /* minimum capacity allocated by push_back() */                                                                                   \
+  static constexpr size_t min_capacity = 64;                                                                                        \
+                                                                                                                                    \
+  /* move the elements and the scalars to a new buffer, with room for `elements` elements */                                        \
+  void reallocate(size_t elements) {                                                                                                \
+    assert(elements >= size_);                                                                                                      \
+    std::byte* buffer = allocator_.allocate(compute_data_size(elements), buffer_alignment);                                         \
+    auto offsets = compute_offsets(elements);                                                                                       \
+    if (buffer_) {                                                                                                                  \
+      soa_detail::copy_fields(fields, size_, buffer_, compute_offsets(capacity_), buffer, offsets);                                 \
+      allocator_.deallocate(buffer_, compute_data_size(capacity_), buffer_alignment);                                               \
+    } else {                                                                                                                        \
+      /* value-initialise the scalars of a new SoA, leaving the columns untouched */                                                \
+      soa_detail::zero_scalars(fields, buffer, offsets);                                                                            \
+    }                                                                                                                               \
+    buffer_ = buffer;                                                                                                               \
+    capacity_ = elements;                                                                                                           \
+    _DECLARE_SOA_VIEW_FROM_BUFFERS(__VA_ARGS__)                                                                                     \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  ALLOCATOR allocator_;                                                                                                             \
+  std::byte* buffer_ = nullptr;                                                                                                     \
+  size_t capacity_ = 0;                                                                                                             \
+};                                                                                                                                  \
+                                                                                                                                    \
+/* runtime sized, tiled SoA (array of structures of arrays) inside a single caller-provided buffer: the columns of each group of    \
+ * TILE consecutive elements are stored together in a tile, followed by the scalars */                                              \
+template <size_t TILE, size_t ALIGN=0>                                                                                              \
+struct BOOST_PP_CAT(CLASS, Tiled) {                                                                                                 \
+                                                                                                                                    \
+  using self_type = BOOST_PP_CAT(CLASS, Tiled);                                                                                     \
+  static const size_t tile_size = TILE;                                                                                             \
+  static const size_t alignment = ALIGN;                                                                                            \
+                                                                                                                                    \
+  /* the columns of TILE consecutive elements */                                                                                    \
+  struct tile_type {                                                                                                                \
+    _DECLARE_SOA_TILE_MEMBERS(__VA_ARGS__)                                                                                          \
+  };                                                                                                                                \
+                                                                                                                                    \
+  /* the scalars */                                                                                                                 \
+  struct scalars_type {                                                                                                             \
+    _DECLARE_SOA_TILED_SCALAR_MEMBERS(__VA_ARGS__)                                                                                  \
+  };                                                                                                                                \
+                                                                                                                                    \
+  /* strided access to the elements of a column */                                                                                  \
+  template <typename T>                                                                                                             \
+  using column_type = soa_tiled_column<T, TILE>;                                                                                    \
+                                                                                                                                    \
+  /* alignment required for the buffer */                                                                                           \
+  static constexpr size_t buffer_alignment = std::max(alignof(tile_type), alignof(scalars_type));                                   \
+                                                                                                                                    \
+  /* number of tiles required to hold the given number of elements */                                                               \
+  static constexpr                                                                                                                  \
+  size_t compute_tiles(size_t elements) {                                                                                           \
+    return (elements + TILE - 1) / TILE;                                                                                            \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* size in bytes of the buffer required to hold a SoA with the given number of elements */                                        \
+  static constexpr                                                                                                                  \
+  size_t compute_data_size(size_t elements) {                                                                                       \
+    return soa_detail::next_multiple(                                                                                               \
+        soa_detail::next_multiple(compute_tiles(elements) * sizeof(tile_type), alignof(scalars_type)) + sizeof(scalars_type),       \
+        buffer_alignment);                                                                                                          \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* the buffer must be aligned to buffer_alignment, and at least compute_data_size(elements) bytes long */                         \
+  BOOST_PP_CAT(CLASS, Tiled)(std::byte* buffer, size_t elements) :                                                                  \
+    tiles_(reinterpret_cast<tile_type*>(buffer)),                                                                                   \
+    scalars_(reinterpret_cast<scalars_type*>(                                                                                       \
+        buffer + soa_detail::next_multiple(compute_tiles(elements) * sizeof(tile_type), alignof(scalars_type)))),                   \
+    size_(elements)                                                                                                                 \
+  {                                                                                                                                 \
+    assert(reinterpret_cast<uintptr_t>(buffer) % buffer_alignment == 0);                                                            \
+  }                                                                                                                                 \
+                                                                                                                                    \
+  /* AoS-like accessor to individual elements */                                                                                    \
+  using value_type = BOOST_PP_CAT(CLASS, Entry);                                                                                    \
+  _DECLARE_SOA_ELEMENT_TYPES(BOOST_PP_CAT(CLASS, Tiled) const, BOOST_PP_CAT(CLASS, Tiled) const, __VA_ARGS__)                       \
+                                                                                                                                    \
+  /* AoS-like accessor */                                                                                                           \
+  SOA_HOST_DEVICE                                                                                                                   \
+  element operator[](size_t index) const { return element(*this, index); }                                                          \
+                                                                                                                                    \
+  /* iterators over the elements */                                                                                                 \
+  using iterator = soa_iterator<BOOST_PP_CAT(CLASS, Tiled), element>;                                                               \
+  using const_iterator = soa_iterator<BOOST_PP_CAT(CLASS, Tiled), const_element>;                                                   \
+                                                                                                                                    \
+  SOA_HOST_DEVICE iterator begin() const { return iterator(*this, 0); }                                                             \
+  SOA_HOST_DEVICE iterator end() const { return iterator(*this, size_); }                                                           \
+  SOA_HOST_DEVICE const_iterator cbegin() const { return const_iterator(*this, 0); }                                                \
+  SOA_HOST_DEVICE const_iterator cend() const { return const_iterator(*this, size_); }                                              \
+                                                                                                                                    \
+  /* number of elements */                                                                                                          \
+  SOA_HOST_DEVICE                                                                                                                   \
+  size_t size() const { return size_; }                                                                                             \
+                                                                                                                                    \
+  /* number of tiles */                                                                                                             \
+  SOA_HOST_DEVICE                                                                                                                   \
+  size_t tiles() const { return compute_tiles(size_); }                                                                             \
+                                                                                                                                    \
+  /* access to the columns of a single tile */                                                                                      \
+  SOA_HOST_DEVICE                                                                                                                   \
+  tile_type & tile(size_t t) const { return tiles_[t]; }                                                                            \
+                                                                                                                                    \
+  /* accessors */                                                                                                                   \
+  _DECLARE_SOA_TILED_ACCESSORS(__VA_ARGS__)                                                                                         \
+                                                                                                                                    \
+private:                                                                                                                            \
+  tile_type* tiles_;                                                                                                                \
+  scalars_type* scalars_;                                                                                                           \
+  size_t size_;                                                                                                                     \
+};                                                                                                                                  \
+                                                                                                                                    \
+/* dump the SoA internal structure, the size of the same SoA with the fields in declaration order and sorted by alignment,          \
+ * and the bytes saved by its order with respect to declaration order */                                                            \
+template <typename T>                                                                                                               \
+SOA_HOST_ONLY                                                                                                                       \
+void dump() {                                                                                                                       \
+  constexpr size_t declared = sizeof(CLASS<T::size, T::alignment, soa_declaration_order>);                                          \
+  constexpr size_t sorted = sizeof(CLASS<T::size, T::alignment, soa_alignment_order>);                                              \
+  using SoA = T;                                                                                                                    \
+  std::cout << #CLASS "<" << SoA::size << ", " << SoA::alignment << "): " << '\n';                                                  \
+  std::cout << "  sizeof(...): " << sizeof(SoA) << '\n';                                                                            \
+  std::cout << "  alignof(...): " << alignof(SoA) << '\n';                                                                          \
+  _DECLARE_SOA_DUMP_INFOS(__VA_ARGS__)                                                                                              \
+  std::cout << "  in declaration order: " << declared << " bytes, sorted by alignment: " << sorted << " bytes" << '\n';             \
+  std::cout << "  saving " << static_cast<std::ptrdiff_t>(declared - sizeof(SoA)) << " bytes with respect to declaration order"     \
+            << '\n';                                                                                                                \
+  std::cout << std::endl;                                                                                                           \
 }
+
+#endif  // SOA_V4_H
@@ -0,0 +1,148 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "soa_v4.h"
+#include "soa_algorithm.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int32_t, value),
+  SoA_column(const char *, name),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+template <typename SOA>
+void fill(SOA& soa) {
+  for (size_t i = 0; i < soa.view().size(); ++i)
+    soa[i] = SoAEntry{ double(i), 2. * i, -1. * i, uint16_t(i % 7), int32_t(i * 37 % 101), "element" };
+  soa.description() = "test SoA";
+}
+
+
+int main(void) {
+  std::cout << std::boolalpha;
+  bool ok = true;
+
+  // filter into a different SoA
+  {
+    SoA<100, 32> source;
+    SoA<128, 64> destination;
+    fill(source);
+    size_t count = soa_filter(source, destination, [](auto const& e) { return e.value() > 50; });
+    check(count);
+    check(destination.description());
+    bool filtered = true;
+    size_t j = 0;
+    for (size_t i = 0; i < 100; ++i) {
+      if (source[i].value() > 50) {
+        filtered = filtered and destination[j].x() == source[i].x() and destination[j].value() == source[i].value();
+        ++j;
+      }
+    }
+    check(filtered);
+    ok = ok and filtered and count == j;
+  }
+  std::cout << std::endl;
+
+  // compact in place
+  {
+    using Layout = SoALayout<64>;
+    const size_t elements = 1000;
+    std::byte* buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+    Layout soa(buffer, elements);
+    fill(soa);
+    size_t count = soa_compact(soa, [](SoAView::const_element e) { return e.colour() == 3; });
+    check(count);
+    auto kept = soa.subspan(0, count);
+    bool compacted = true;
+    for (size_t i = 0; i < kept.size(); ++i)
+      compacted = compacted and kept[i].colour() == 3 and kept[i].x() == 3. + 7 * i and kept[i].z() == -kept[i].x();
+    check(compacted);
+    ok = ok and compacted and count == 143;
+    std::free(buffer);
+  }
+  std::cout << std::endl;
+
+  // bulk copy across sizes, alignments, and owning and view types
+  {
+    SoA<100, 32> source;
+    SoA<128, 64> destination;
+    fill(source);
+    soa_copy(destination, source);
+    bool copied = destination[99].y() == 198. and destination[42].value() == 42 * 37 % 101 and
+                  destination.description() == std::string("test SoA");
+
+    // copy a range into a view over a larger, runtime sized SoA
+    std::byte* buffer = static_cast<std::byte*>(std::aligned_alloc(SoALayout<64>::buffer_alignment, SoALayout<64>::compute_data_size(1000)));
+    SoALayout<64> layout(buffer, 1000);
+    layout.view().subspan(0, 100)[50].x() = -1.;
+    soa_copy(layout.view(), source.view(), 10, 20);
+    copied = copied and layout[10].x() == 10. and layout[29].z() == -29. and layout[50].x() == -1.;
+    check(destination[99].y());
+    check(layout[29].z());
+    check(copied);
+    ok = ok and copied;
+    std::free(buffer);
+  }
+  std::cout << std::endl;
+
+  // streaming copy and fill, with non-temporal stores
+  {
+    SoA<1000, 64> source;
+    SoA<1000, 64> destination;
+    fill(source);
+    soa_copy(destination, source, soa_store_policy::streaming);
+    bool streamed = destination[999].y() == 1998. and destination[500].value() == 500 * 37 % 101 and
+                    destination[123].colour() == 123 % 7 and destination.description() == std::string("test SoA");
+
+    // a range that does not start on an aligned block, into a column with a smaller alignment
+    SoA<1000, 8> other;
+    fill(other);
+    soa_fill(other, 3, 990, &SoAView::x, -1., soa_store_policy::streaming);
+    soa_fill(other, &SoAView::colour, uint16_t(9), soa_store_policy::streaming);
+    soa_copy(destination, other, 5, 17, soa_store_policy::streaming);
+    for (size_t i = 0; i < 1000; ++i)
+      streamed = streamed and other[i].x() == ((i >= 3 and i < 993) ? -1. : double(i)) and other[i].colour() == 9 and
+                 destination[i].x() == ((i >= 5 and i < 22) ? -1. : double(i));
+    check(destination[999].y());
+    check(other[992].x());
+    check(streamed);
+    ok = ok and streamed;
+  }
+  std::cout << std::endl;
+
+  // sort by one column
+  {
+    SoA<100, 64> soa;
+    fill(soa);
+    soa_sort_by(soa, &SoAView::value);
+    bool sorted = true;
+    for (size_t i = 1; i < 100; ++i)
+      sorted = sorted and soa[i - 1].value() <= soa[i].value();
+    bool consistent = true;
+    for (size_t i = 0; i < 100; ++i)
+      consistent = consistent and soa[i].value() == int32_t(size_t(soa[i].x()) * 37 % 101) and soa[i].y() == 2. * soa[i].x();
+    check(soa[0].value());
+    check(soa[99].value());
+    check(sorted);
+    check(consistent);
+
+    // sort in decreasing order of z, through a lambda returning the key column
+    soa_sort_by(soa, [](SoAView const& view) { return view.z(); }, std::greater<>());
+    check(soa[0].z());
+    check(soa[99].z());
+    ok = ok and sorted and consistent and soa[0].z() == 0. and soa[99].z() == -99.;
+  }
+
+  return not ok;
+}
@@ -0,0 +1,150 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "soa_v4.h"
+#include "soa_codec.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int32_t, value),
+  SoA_column(const char *, name),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+int main(void) {
+  std::cout << std::boolalpha;
+  bool ok = true;
+
+  using Layout = SoALayout<64>;
+  const size_t elements = 10000;
+  std::byte* source_buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+  std::byte* destination_buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+  Layout source(source_buffer, elements);
+  Layout destination(destination_buffer, elements);
+  for (size_t i = 0; i < elements; ++i)
+    source[i] = SoAEntry{ 0.5 * i, 1000. + i, 0., uint16_t(1000 + i % 7), int32_t(3 * i - 100), "element" };
+
+  // small range of values: 3 bits per value
+  auto colour = soa_encode(soa_codec::frame_of_reference, source.colour(), elements);
+  soa_decode(colour, destination.colour(), soa_decoded_count(colour));
+  check(colour.size());
+  bool colour_ok = std::equal(source.colour(), source.colour() + elements, destination.colour());
+  check(colour_ok);
+
+  // monotone values: 3 bits per value, as zig-zag encoded differences
+  auto value = soa_encode(soa_codec::delta, source.value(), elements);
+  soa_decode(value, destination.value(), elements);
+  check(value.size());
+  bool value_ok = std::equal(source.value(), source.value() + elements, destination.value());
+  check(value_ok);
+
+  // long runs of equal values
+  for (size_t i = 0; i < elements; ++i)
+    source.colour()[i] = i / 1000;
+  auto runs = soa_encode(soa_codec::run_length, source.colour(), elements);
+  soa_decode(runs, destination.colour(), elements);
+  check(runs.size());
+  bool runs_ok = std::equal(source.colour(), source.colour() + elements, destination.colour());
+  check(runs_ok);
+
+  // floating point values with the same high bytes
+  auto x = soa_encode(soa_codec::byte_shuffle, source.x(), elements);
+  soa_decode(x, destination.x(), elements);
+  bool x_ok = std::equal(source.x(), source.x() + elements, destination.x());
+  check(x_ok);
+
+  // negative differences and the full range of the type
+  std::vector<int64_t> extremes = { 0, INT64_MAX, INT64_MIN, -1, 1, INT64_MIN, INT64_MAX };
+  std::vector<int64_t> decoded(extremes.size());
+  soa_decode(soa_encode(soa_codec::delta, extremes.data(), extremes.size()), decoded.data(), decoded.size());
+  bool delta_ok = decoded == extremes;
+  soa_decode(soa_encode(soa_codec::frame_of_reference, extremes.data(), extremes.size()), decoded.data(), decoded.size());
+  bool reference_ok = decoded == extremes;
+  check(delta_ok);
+  check(reference_ok);
+
+  // codec chosen at compile time; soa_encode<soa_codec::delta>(source.x(), elements) would not compile
+  bool compile_time_ok = soa_encode<soa_codec::delta>(source.value(), elements) == value and
+                         not soa_codec_supports<soa_codec::frame_of_reference, double>;
+  check(compile_time_ok);
+
+  // unsupported combinations chosen at runtime, and corrupted columns
+  bool unsupported = false;
+  try {
+    soa_encode(soa_codec::frame_of_reference, source.x(), elements);
+  } catch (std::invalid_argument const&) {
+    unsupported = true;
+  }
+  bool mismatched = false;
+  auto integers = soa_encode(soa_codec::frame_of_reference, reinterpret_cast<uint64_t const*>(source.x()), elements);
+  try {
+    soa_decode(integers, destination.x(), elements);
+  } catch (std::runtime_error const&) {
+    mismatched = true;
+  }
+  bool corrupted = false;
+  uint32_t length = 1000000;
+  std::memcpy(runs.data() + sizeof(soa_codec_header) + sizeof(uint16_t) * 10, &length, sizeof(length));
+  destination.colour()[0] = 12345;
+  try {
+    soa_decode(runs, destination.colour(), elements);
+  } catch (std::runtime_error const&) {
+    corrupted = destination.colour()[0] == 12345;
+  }
+  bool truncated = false;
+  try {
+    soa_decode(value.data(), value.size() - 8, destination.value(), elements);
+  } catch (std::runtime_error const&) {
+    truncated = true;
+  }
+  bool wrong_count = false;
+  try {
+    soa_decode(value, destination.value(), elements - 1);
+  } catch (std::runtime_error const&) {
+    wrong_count = true;
+  }
+  check(unsupported);
+  check(mismatched);
+  check(corrupted);
+  check(truncated);
+  check(wrong_count);
+
+  // bit-packed with 0 bits per value: a constant column, and a single value; the encoded bytes are copied into buffers of
+  // exactly their size, so that reading past the end is caught by the address sanitizer
+  bool constant_ok = true;
+  std::vector<int32_t> constant(100, 42);
+  std::vector<int32_t> single = { -7 };
+  for (auto const* input: { &constant, &single }) {
+    for (soa_codec codec: { soa_codec::frame_of_reference, soa_codec::delta }) {
+      auto encoded = soa_encode(codec, input->data(), input->size());
+      auto* exact = new std::byte[encoded.size()];
+      std::memcpy(exact, encoded.data(), encoded.size());
+      std::vector<int32_t> output(input->size());
+      soa_decode(exact, encoded.size(), output.data(), output.size());
+      constant_ok = constant_ok and output == *input;
+      delete[] exact;
+    }
+  }
+  check(constant_ok);
+
+  ok = colour_ok and value_ok and runs_ok and x_ok and delta_ok and reference_ok and colour.size() < elements * sizeof(uint16_t) / 4 and
+       value.size() < elements * sizeof(int32_t) / 8 and runs.size() < 100 and compile_time_ok and unsupported and mismatched and
+       corrupted and truncated and wrong_count and constant_ok;
+
+  std::free(source_buffer);
+  std::free(destination_buffer);
+  return not ok;
+}
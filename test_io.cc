@@ -0,0 +1,165 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+#include "soa_v4.h"
+#include "soa_io.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int32_t, value),
+  SoA_column(const char *, name),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+// same columns, with a different type; in a separate namespace, to avoid clashing with the dump() function declared for
+// the first SoA
+namespace other {
+declare_SoA_template(Other,
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int64_t, value),
+  SoA_column(const char *, name),
+  SoA_scalar(const char *, description)
+);
+}
+
+// reduced precision and bit-packed columns
+namespace packed {
+declare_SoA_template(Packed,
+  SoA_column(double, x),
+  SoA_half_column(energy),
+  SoA_packed_column(5, layer),
+  SoA_flag_column(selected),
+  SoA_scalar(const char *, description)
+);
+}
+
+int main(void) {
+  std::cout << std::boolalpha;
+  bool ok = true;
+
+  char path[] = "/tmp/test_io_XXXXXX";
+  int fd = mkstemp(path);
+  close(fd);
+
+  // write a compile-time sized SoA, laid out as a runtime sized one
+  using Layout = SoALayout<64>;
+  auto soa = std::make_unique<SoA<1000, 64>>();
+  for (size_t i = 0; i < 1000; ++i)
+    (*soa)[i] = SoAEntry{ double(i), 2. * i, 3. * i, uint16_t(i % 7), int32_t(i * i), nullptr };
+  soa_write_file<Layout>(path, *soa);
+
+  // map it back
+  {
+    soa_mapped_file<Layout> file(path);
+    SoAConstView view = file.view();
+    check(file.size());
+    check(view[999].z());
+    check(view[999].value());
+    check(reinterpret_cast<uintptr_t>(view.colour()) % 64 == 0);
+    bool same = file.size() == 1000;
+    for (size_t i = 0; same and i < 1000; ++i)
+      same = view[i].x() == soa->x()[i] and view[i].colour() == soa->colour()[i] and view[i].value() == soa->value()[i];
+    check(same);
+    ok = ok and same;
+  }
+
+  // the same SoA in a layout sorted by alignment is a different file
+  bool different = false;
+  try {
+    soa_mapped_file<SoALayout<64, soa_alignment_order>> file(path);
+  } catch (std::runtime_error const& e) {
+    std::cout << e.what() << std::endl;
+    different = true;
+  }
+
+  // and so is a SoA with different fields
+  bool mismatch = false;
+  try {
+    soa_mapped_file<other::OtherLayout<64>> file(path);
+  } catch (std::runtime_error const& e) {
+    std::cout << e.what() << std::endl;
+    mismatch = true;
+  }
+  check(different);
+  check(mismatch);
+  ok = ok and different and mismatch;
+
+  // the packed columns are written as their words
+  {
+    auto packed = std::make_unique<packed::Packed<1000, 64>>();
+    for (size_t i = 0; i < 1000; ++i)
+      (*packed)[i] = packed::PackedEntry{ double(i), 0.5f * (i % 9), uint32_t(i % 32), i % 3 == 0 };
+    soa_write_file<packed::PackedLayout<64>>(path, *packed);
+    soa_mapped_file<packed::PackedLayout<64>> file(path);
+    auto view = file.view();
+    bool same = file.size() == 1000;
+    for (size_t i = 0; same and i < 1000; ++i)
+      same = view[i].x() == double(i) and view[i].energy() == 0.5f * (i % 9) and view[i].layer() == i % 32 and
+             view[i].selected() == (i % 3 == 0);
+    check(view[999].layer());
+    check(same);
+    ok = ok and same;
+  }
+
+  // stream 10000 elements, appended in blocks of up to 3000 and written in chunks of up to 1024: 3 x (1024 + 1024 + 952) + 1000
+  {
+    auto block = std::make_unique<SoA<3000, 64>>();
+    block->description() = "stream";
+    soa_stream_writer<SoAView> writer(path, 1024);
+    for (size_t b = 0; b < 4; ++b) {
+      size_t size = (b < 3) ? 3000 : 1000;
+      for (size_t i = 0; i < size; ++i) {
+        size_t n = b * 3000 + i;
+        (*block)[i] = SoAEntry{ double(n), 2. * n, 3. * n, uint16_t(n % 7), int32_t(n), nullptr };
+      }
+      writer.append(block->view().subspan(0, size));
+    }
+    check(writer.size());
+    writer.close();
+  }
+
+  // read back only the x and value columns
+  {
+    soa_stream_reader<Layout> reader(path, { "x", "value" });
+    check(reader.size());
+    check(reader.selected(0));
+    check(reader.selected(1));
+    size_t chunks = 0;
+    size_t elements = 0;
+    bool streamed = true;
+    for (SoAConstView chunk = reader.next(); chunk.size() > 0; chunk = reader.next()) {
+      for (size_t i = 0; i < chunk.size(); ++i) {
+        size_t n = elements + i;
+        streamed = streamed and chunk[i].x() == double(n) and chunk[i].value() == int32_t(n) and chunk[i].z() == 0.;
+      }
+      streamed = streamed and chunk.description() == std::string("stream");
+      elements += chunk.size();
+      ++chunks;
+    }
+    check(chunks);
+    check(elements);
+    check(streamed);
+    ok = ok and streamed and chunks == 10 and elements == 10000 and reader.selected(0) and not reader.selected(1);
+  }
+
+  unlink(path);
+  return not ok;
+}
@@ -0,0 +1,92 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "soa_v4.h"
+#include "soa_mask.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_nullable_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_nullable_column(int32_t, value),
+  SoA_column(const char *, name),
+  SoA_flag_column(selected),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+int main(void) {
+  std::cout << std::boolalpha;
+  bool ok = true;
+
+  using Layout = SoALayout<64>;
+  const size_t elements = 1000;
+  std::byte* buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+  Layout soa(buffer, elements);
+
+  // x is filled in for every third element, and value for the elements from 100 to 899
+  for (size_t i = 0; i < elements; ++i) {
+    soa[i].x() = (i % 3 == 0) ? 1.0 * i : -1.;
+    soa[i].x_valid() = (i % 3 == 0);
+    soa[i].value() = (i >= 100 and i < 900) ? int32_t(i) : -1;
+    soa[i].value_valid() = (i >= 100 and i < 900);
+  }
+
+  check(soa_mask_count(soa.x_valid(), elements));
+  check(soa_mask_count(soa.value_valid(), elements));
+  ok = ok and soa_mask_count(soa.x_valid(), elements) == 334 and soa_mask_count(soa.value_valid(), elements) == 800;
+
+  // reduce over the valid elements only
+  double sum = soa_masked_sum(soa.x(), soa.x_valid(), elements);
+  int32_t value_sum = soa_masked_sum(soa.value(), soa.value_valid(), elements);
+  double expected = 0.;
+  int32_t expected_value = 0;
+  for (size_t i = 0; i < elements; i += 3)
+    expected += i;
+  for (size_t i = 100; i < 900; ++i)
+    expected_value += i;
+  check(sum);
+  check(value_sum);
+  ok = ok and sum == expected and value_sum == expected_value;
+
+  // filter: the elements with both fields filled in, and an even value
+  soa_mask_from(soa.selected(), soa.value(), elements, [](int32_t v) { return v % 2 == 0; });
+  soa_mask_and(soa.selected(), soa.selected(), soa.value_valid(), elements);
+  soa_mask_and(soa.selected(), soa.selected(), soa.x_valid(), elements);
+  std::vector<size_t> indices(elements);
+  indices.resize(soa_mask_indices(soa.selected(), elements, indices.data()));
+  bool filter_ok = true;
+  size_t expected_size = 0;
+  for (size_t i = 0; i < elements; ++i)
+    if (i % 6 == 0 and i >= 100 and i < 900)
+      filter_ok = filter_ok and indices[expected_size++] == i;
+  filter_ok = filter_ok and indices.size() == expected_size;
+  check(indices.size());
+  check(filter_ok);
+  ok = ok and filter_ok;
+
+  // bitmaps starting in the middle of a word, through a subspan
+  auto view = soa.view().subspan(10, 500);
+  soa_mask_or(view.selected(), view.x_valid(), view.value_valid(), view.size());
+  soa_mask_not(view.x_valid(), view.x_valid(), view.size());
+  bool subspan_ok = true;
+  for (size_t i = 0; i < elements; ++i) {
+    bool inside = (i >= 10 and i < 510);
+    subspan_ok = subspan_ok and soa[i].selected() == (inside ? (i % 3 == 0 or i >= 100) : (i % 6 == 0 and i >= 100 and i < 900)) and
+                 soa[i].x_valid() == (inside ? i % 3 != 0 : i % 3 == 0);
+  }
+  check(soa_mask_count(view.selected(), view.size()));
+  check(subspan_ok);
+  ok = ok and subspan_ok and soa_mask_count(view.selected(), view.size()) == 410 + 30;
+
+  std::free(buffer);
+  return not ok;
+}
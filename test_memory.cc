@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+#include "soa_v4.h"
+#include "soa_memory.h"
+#include "soa_parallel.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int32_t, value),
+  SoA_column(const char *, name),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+using LargeSoA = SoA<1024, 64>;
+
+int main(void) {
+  std::cout << std::boolalpha;
+  bool ok = true;
+
+  soa_arena arena(1 << 20);
+  const std::byte* first = nullptr;
+  for (int event = 0; event < 3; ++event) {
+    // a set of SoAs for each event
+    LargeSoA& large = arena.create<LargeSoA>();
+    auto hits = arena.make<SoALayout<64>>(1000);
+    auto tiles = arena.make<SoATiled<8, 64>>(1000);
+    large[1023].z() = 42.;
+    hits[999].name() = "hit";
+    tiles[999].value() = 999;
+    hits.description() = "hits";
+
+    bool aligned = reinterpret_cast<uintptr_t>(large.colour()) % 64 == 0 and reinterpret_cast<uintptr_t>(hits.colour()) % 64 == 0;
+    bool reused = (event == 0) ? (first = reinterpret_cast<std::byte*>(&large), true) : (first == reinterpret_cast<std::byte*>(&large));
+    if (event == 2) {
+      check(aligned);
+      check(reused);
+      check(arena.slabs());
+      check(large[1023].z());
+      check(hits[999].name());
+    }
+    ok = ok and aligned and reused and large[1023].z() == 42. and tiles[999].value() == 999;
+
+    // release all the SoAs of this event at once
+    arena.reset();
+  }
+
+  // allocations larger than a slab get their own slab
+  arena.allocate(3 << 20, 64);
+  check(arena.slabs());
+  check(arena.capacity());
+  ok = ok and arena.slabs() == 2 and arena.capacity() == (1 << 20) + (3 << 20);
+  arena.release();
+  check(arena.capacity());
+
+  // growable SoA in a per-thread arena
+  std::thread thread([&ok] {
+    SoAVector<64, soa_arena_allocator> soa;
+    for (int i = 0; i < 1000; ++i)
+      soa.emplace_back(double(i), 0., 0., uint16_t(0), int32_t(i), "element");
+    bool grown = soa.size() == 1000 and soa[999].x() == 999. and soa_arena::thread_instance().slabs() == 1;
+    check(grown);
+    ok = ok and grown;
+  });
+  thread.join();
+
+  // growable SoA on transparent huge pages
+  {
+    using Allocator = soa_page_allocator<soa_page_policy::transparent_huge>;
+    SoAVector<64, Allocator> soa;
+    soa.reserve(100000);
+    for (int i = 0; i < 100000; ++i)
+      soa.emplace_back(double(i), 0., 0., uint16_t(0), int32_t(i), "element");
+    check(reinterpret_cast<uintptr_t>(soa.buffer()) % Allocator::huge_page_size == 0);
+    ok = ok and reinterpret_cast<uintptr_t>(soa.buffer()) % Allocator::huge_page_size == 0 and soa[99999].value() == 99999;
+  }
+
+  // runtime sized SoA on huge pages (or transparent huge pages, if no huge pages are available), interleaved across the
+  // NUMA nodes, and on regular pages placed by the workers that first touch them
+  {
+    using Layout = SoALayout<64>;
+    const size_t elements = 1 << 20;
+    soa_page_allocator<soa_page_policy::huge, soa_numa_policy::interleave> huge;
+    std::byte* buffer = huge.allocate(Layout::compute_data_size(elements), Layout::buffer_alignment);
+    Layout soa(buffer, elements);
+    soa[elements - 1].z() = 42.;
+    check(soa[elements - 1].z());
+    ok = ok and soa[elements - 1].z() == 42.;
+    huge.deallocate(buffer, Layout::compute_data_size(elements), Layout::buffer_alignment);
+
+    soa_page_allocator<soa_page_policy::normal, soa_numa_policy::first_touch> local;
+    buffer = local.allocate(Layout::compute_data_size(elements), Layout::buffer_alignment);
+    Layout touched(buffer, elements);
+    soa_first_touch(touched);
+    check(touched[elements - 1].x());
+    ok = ok and touched[elements - 1].x() == 0.;
+    local.deallocate(buffer, Layout::compute_data_size(elements), Layout::buffer_alignment);
+  }
+
+  return not ok;
+}
@@ -0,0 +1,187 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#include "soa_v4.h"
+#include "soa_parallel.h"
+#include "soa_algorithm.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+// the same content as the SoA in test_v4.cc, with reduced precision and bit-packed columns
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_half_column(x),
+  SoA_half_column(y),
+  SoA_bfloat16_column(z),
+  SoA_packed_column(3, colour),
+  SoA_packed_column(12, value),
+  SoA_flag_column(selected),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+int main(void) {
+  std::cout << std::boolalpha;
+  bool ok = true;
+
+  // half precision and bfloat16 conversions
+  bool half_ok = float(soa_half(1.5f)) == 1.5f and float(soa_half(-65504.f)) == -65504.f and
+                 float(soa_half(70000.f)) == std::numeric_limits<float>::infinity() and float(soa_half(5.9604645e-08f)) == 5.9604645e-08f and
+                 float(soa_half(1.f + 1.f / 2048)) == 1.f and float(soa_half(1.f + 3.f / 4096)) == 1.f + 1.f / 1024 and
+                 std::isnan(float(soa_half(std::nanf(""))));
+  bool bfloat16_ok = float(soa_bfloat16(1.5f)) == 1.5f and float(soa_bfloat16(1.f + 3.f / 512)) == 1.f + 1.f / 128 and
+                     float(soa_bfloat16(1.f + 1.f / 256)) == 1.f and std::isnan(float(soa_bfloat16(std::nanf(""))));
+  check(half_ok);
+  check(bfloat16_ok);
+  ok = ok and half_ok and bfloat16_ok;
+
+  // footprint of the compile-time sized SoA, compared to the 31 bytes per element of double, uint16_t, int32_t and bool columns
+  check(sizeof(SoA<1024, 64>));
+  ok = ok and sizeof(SoA<1024, 64>) < 1024 * 31 / 2;
+
+  // element accessors
+  using Layout = SoALayout<64>;
+  const size_t elements = 1000;
+  std::byte* buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+  Layout soa(buffer, elements);
+  for (size_t i = 0; i < elements; ++i)
+    soa[i] = SoAEntry{ 0.5f * i, 1000.f + i, -0.25f * i, uint32_t(i % 7), uint32_t(3 * i), i % 3 == 0 };
+  soa[10].value() = 4095;
+  soa[11].value() = soa[10].value();
+  soa[12].selected() = true;
+  bool elements_ok = true;
+  for (size_t i = 0; i < elements; ++i) {
+    SoAEntry entry = soa[i];
+    elements_ok = elements_ok and entry.x == 0.5f * i and entry.y == float(soa_half(1000.f + i)) and entry.z == float(soa_bfloat16(-0.25f * i)) and
+                  entry.colour == i % 7 and entry.value == ((i == 10 or i == 11) ? 4095 : (3 * i) % 4096) and
+                  entry.selected == (i % 3 == 0 or i == 12);
+  }
+  check(elements_ok);
+  check(soa[999].value());
+  check(soa.view().subspan(10, 3)[2].selected());
+  ok = ok and elements_ok;
+
+  // bulk conversions
+  std::vector<float> xs(elements);
+  std::vector<uint32_t> colours(elements);
+  soa_unpack(xs.data(), soa.x(), elements);
+  soa_unpack(colours.data(), soa.colour(), elements);
+  bool unpack_ok = true;
+  for (size_t i = 0; i < elements; ++i)
+    unpack_ok = unpack_ok and xs[i] == soa[i].x() and colours[i] == soa[i].colour();
+  for (size_t i = 0; i < elements; ++i) {
+    xs[i] = 0.25f * i;
+    colours[i] = (i + 1) % 8;
+  }
+  soa_pack(soa.y(), xs.data(), elements);
+  soa_pack(soa.view().subspan(5, 900).colour(), colours.data(), 900);
+  bool pack_ok = true;
+  for (size_t i = 0; i < elements; ++i)
+    pack_ok = pack_ok and soa[i].y() == 0.25f * i and soa[i].colour() == ((i >= 5 and i < 905) ? (i - 4) % 8 : i % 7);
+  check(unpack_ok);
+  check(pack_ok);
+  ok = ok and unpack_ok and pack_ok;
+
+  // the bulk bfloat16 conversions round exactly like the element accessors, including ties, infinities, NaNs and subnormals
+  std::vector<float> special = { 1.f + 1.f / 256, 1.f + 3.f / 256, -1.f - 1.f / 256, 3.4e38f, -std::numeric_limits<float>::infinity(),
+                                 std::nanf(""), -std::nanf(""), 1e-40f, -0.f, 0.f, 65504.f, -2.5e-3f };
+  for (size_t i = 0; i < 1000; ++i)
+    special.push_back(std::ldexp(1.f + i / 1024.f, int(i % 60) - 30) * ((i % 2) ? -1.f : 1.f));
+  std::vector<soa_bfloat16> bfloat16s(special.size());
+  std::vector<float> widened(special.size());
+  soa_pack(bfloat16s.data(), special.data(), special.size());
+  soa_unpack(widened.data(), bfloat16s.data(), bfloat16s.size());
+  bool bulk_bfloat16_ok = true;
+  for (size_t i = 0; i < special.size(); ++i) {
+    float expected = soa_bfloat16::to_float(soa_bfloat16::from_float(special[i]));
+    bulk_bfloat16_ok = bulk_bfloat16_ok and bfloat16s[i].bits == soa_bfloat16::from_float(special[i]) and
+                       std::memcmp(&widened[i], &expected, sizeof(float)) == 0;
+  }
+  check(bulk_bfloat16_ok);
+  ok = ok and bulk_bfloat16_ok;
+
+  // growable SoA: the packed columns are value-initialised and moved with the others
+  SoAVector<> vector(5);
+  bool zero_ok = not vector[4].selected() and vector[4].value() == 0;
+  for (size_t i = 0; i < 100; ++i)
+    vector.push_back(SoAEntry{ 1.f, 2.f, 3.f, 5, uint32_t(i), true });
+  vector.resize(200);
+  bool vector_ok = zero_ok and vector.size() == 200 and vector[104].value() == 99 and vector[104].selected() and
+                   not vector[105].selected() and vector[199].colour() == 0;
+  check(vector_ok);
+  ok = ok and vector_ok;
+
+  // tiled SoA
+  std::byte* tiled_buffer = static_cast<std::byte*>(std::aligned_alloc(SoATiled<16, 64>::buffer_alignment, SoATiled<16, 64>::compute_data_size(elements)));
+  SoATiled<16, 64> tiled(tiled_buffer, elements);
+  for (size_t i = 0; i < elements; ++i)
+    tiled[i] = soa[i];
+  bool tiled_ok = true;
+  for (size_t i = 0; i < elements; ++i)
+    tiled_ok = tiled_ok and tiled[i].value() == soa[i].value() and tiled[i].selected() == soa[i].selected() and tiled[i].z() == soa[i].z();
+  check(tiled_ok);
+  ok = ok and tiled_ok;
+
+  // parallel first touch: the packed columns are zeroed a whole word at a time, one chunk per task
+  {
+    soa_thread_pool pool(4);
+    const size_t touched_elements = 100000;
+    using Layout = SoALayout<soa_cache_line_size>;
+    std::byte* touched_buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(touched_elements)));
+    std::memset(touched_buffer, 0xff, Layout::compute_data_size(touched_elements));
+    Layout touched(touched_buffer, touched_elements);
+    soa_first_touch(pool, touched);
+    bool touched_ok = true;
+    for (size_t i = 0; i < touched_elements; ++i)
+      touched_ok = touched_ok and touched[i].x() == 0.f and touched[i].z() == 0.f and touched[i].colour() == 0 and
+                   touched[i].value() == 0 and not touched[i].selected();
+    check(touched_ok);
+    ok = ok and touched_ok;
+    std::free(touched_buffer);
+  }
+
+  // streaming fill of the packed columns: whole words for the flags, one element at a time for the 3-bit colours
+  {
+    SoA<1000, 64> filled;
+    soa_fill(filled, &SoAView::selected, false);
+    soa_fill(filled, &SoAView::colour, 1);
+    soa_fill(filled, 5, 900, &SoAView::selected, true, soa_store_policy::streaming);
+    soa_fill(filled, 7, 500, &SoAView::colour, 6, soa_store_policy::streaming);
+    bool filled_ok = true;
+    for (size_t i = 0; i < 1000; ++i)
+      filled_ok = filled_ok and filled[i].selected() == (i >= 5 and i < 905) and filled[i].colour() == ((i >= 7 and i < 507) ? 6u : 1u);
+    check(filled_ok);
+    ok = ok and filled_ok;
+  }
+
+  // column-wise algorithms over the packed columns
+  {
+    SoA<100, 64> sorted;
+    for (size_t i = 0; i < 100; ++i)
+      sorted[i] = SoAEntry{ float(i), 0.f, 0.f, uint32_t(i % 8), uint32_t(99 - i), i % 2 == 0 };
+    soa_sort_by(sorted.view(), &SoAView::value);
+    bool sorted_ok = true;
+    for (size_t i = 0; i < 100; ++i)
+      sorted_ok = sorted_ok and sorted[i].value() == i and sorted[i].x() == 99.f - i and sorted[i].colour() == (99 - i) % 8 and
+                  sorted[i].selected() == (i % 2 == 1);
+    size_t kept = soa_compact(sorted.view(), [](SoAEntry const& entry) { return entry.selected; });
+    SoA<100, 64> gathered;
+    soa_gather(sorted, gathered.view(), { 3, 1, 4 });
+    bool compacted_ok = kept == 50 and gathered[0].value() == 7 and gathered[1].value() == 3 and gathered[2].value() == 9 and
+                        gathered[2].colour() == (99 - 9) % 8 and gathered[2].selected();
+    check(sorted_ok);
+    check(compacted_ok);
+    ok = ok and sorted_ok and compacted_ok;
+  }
+
+  std::free(tiled_buffer);
+  std::free(buffer);
+  return not ok;
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "soa_v4.h"
+#include "soa_parallel.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int32_t, value),
+  SoA_column(const char *, name),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+
+int main(void) {
+  std::cout << std::boolalpha;
+
+  soa_thread_pool pool(4);
+  check(pool.size());
+  check(soa_detail::chunk_granularity<SoAView>());
+  std::cout << std::endl;
+
+  using Layout = SoALayout<soa_cache_line_size>;
+  const size_t elements = 10000;
+  std::byte* input_buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+  std::byte* output_buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+  Layout input(input_buffer, elements);
+  Layout output(output_buffer, elements);
+
+  // check that the chunks are aligned to the cache lines of all the columns
+  std::atomic<bool> aligned = true;
+  soa_for_each_chunk(pool, input, [&](SoAView chunk) {
+    if (reinterpret_cast<uintptr_t>(chunk.colour()) % soa_cache_line_size != 0 or
+        reinterpret_cast<uintptr_t>(chunk.value()) % soa_cache_line_size != 0 or
+        reinterpret_cast<uintptr_t>(chunk.x()) % soa_cache_line_size != 0)
+      aligned = false;
+  });
+  check(aligned);
+
+  // fill the input
+  soa_for_each(pool, input, [&](SoAView::element e) {
+    size_t i = & e.x() - input.x();
+    e = SoAEntry{ double(i), 2. * i, 3. * i, uint16_t(i % 256), int32_t(i), "input" };
+  });
+
+  // transform the input into the output
+  soa_transform(pool, input, output, [](SoAView::const_element in, SoAView::element out) {
+    out = in;
+    out.x() = in.y() + in.z();
+    out.name() = "output";
+  });
+
+  // sum the x column of the output
+  double sum = soa_reduce(pool, output, 0., std::plus<>(), [](SoAView::const_element e) { return e.x(); });
+  double expected = 0.;
+  for (size_t i = 0; i < elements; ++i)
+    expected += 5. * i;
+  check(sum);
+  check(expected);
+
+  // count the elements with an even value, using the application-wide pool
+  size_t even = soa_reduce(output, size_t(0), std::plus<>(), [](SoAView::const_element e) -> size_t { return e.value() % 2 == 0; });
+  check(even);
+
+  // concurrent append into the input from 100 producers, each one reserving batches of up to 7 elements
+  auto appender = soa_make_appender(input);
+  pool.parallel_for(100, [&](size_t producer) {
+    for (size_t i = 0; i < 50; i += 7) {
+      SoAView batch = appender.reserve(std::min<size_t>(7, 50 - i));
+      for (size_t j = 0; j < batch.size(); ++j)
+        batch[j] = SoAEntry{ 0., 0., 0., 0, int32_t(producer * 50 + i + j), "candidate" };
+    }
+  });
+  check(appender.size());
+  check(appender.overflow());
+  std::vector<bool> seen(5000, false);
+  for (auto const& e: appender.view())
+    seen[e.value()] = true;
+  bool appended = appender.size() == 5000 and std::all_of(seen.begin(), seen.end(), [](bool s) { return s; });
+  check(appended);
+
+  // overflow of the preallocated elements
+  appender.clear();
+  std::atomic<size_t> rejected = 0;
+  pool.parallel_for(100, [&](size_t producer) {
+    for (size_t i = 0; i < 150; ++i)
+      if (not appender.push_back(SoAEntry{ 0., 0., 0., 0, int32_t(producer), "candidate" }))
+        ++rejected;
+  });
+  check(appender.size());
+  check(appender.overflow());
+  check(rejected);
+  bool overflow = appender.size() == elements and appender.overflow() and rejected == 15000 - elements;
+
+  // an exception thrown by a task is rethrown by parallel_for(), after all the other tasks have completed
+  std::atomic<size_t> completed = 0;
+  bool rethrown = false;
+  try {
+    pool.parallel_for(1000, [&](size_t i) {
+      if (i % 100 == 7)
+        throw std::runtime_error("task " + std::to_string(i));
+      ++completed;
+    });
+  } catch (std::runtime_error const&) {
+    rethrown = true;
+  }
+  check(rethrown);
+  check(completed);
+  bool exception = rethrown and completed == 990;
+
+  bool ok = aligned and sum == expected and even == elements / 2 and output[9999].colour() == 9999 % 256 and appended and overflow and
+            exception;
+  std::free(input_buffer);
+  std::free(output_buffer);
+
+  return not ok;
+}
@@ -0,0 +1,64 @@
+#include <cstdlib>
+#include <iostream>
+
+#define SOA_PERF
+#include "soa_v4.h"
+#include "soa_perf.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int32_t, value),
+  SoA_column(const char *, name),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+int main(void) {
+  std::cout << std::boolalpha;
+  bool ok = true;
+
+  using Layout = SoALayout<64>;
+  const size_t elements = 100000;
+  std::byte* buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+  Layout soa(buffer, elements);
+
+  // 3 * 8 + 2 + 4 + 8 bytes per element
+  check(soa_column_bytes(soa));
+  ok = ok and soa_column_bytes(soa) == 38 * elements;
+
+  for (int i = 0; i < 2; ++i) {
+    SOA_PERF_REGION("fill", soa_column_bytes(soa));
+    for (size_t j = 0; j < elements; ++j) {
+      soa.x()[j] = j;
+      soa.y()[j] = 2. * j;
+      soa.z()[j] = 3. * j;
+    }
+  }
+
+  double sum = 0.;
+  {
+    SOA_PERF_REGION("sum", sizeof(double) * elements);
+    for (size_t j = 0; j < elements; ++j)
+      sum += soa.x()[j];
+  }
+  check(sum);
+
+  // the counters may not be available, e.g. inside a container, but the regions are always recorded
+  auto regions = soa_perf_registry::instance().regions();
+  check(regions.size());
+  check(regions["fill"].calls);
+  check(regions["fill"].bytes);
+  ok = ok and regions.size() == 2 and regions["fill"].calls == 2 and regions["fill"].bytes == 2 * 38 * elements;
+  soa_perf_report(std::cout);
+
+  std::free(buffer);
+  return not ok;
+}
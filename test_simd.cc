@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "soa_v4.h"
+#include "soa_simd.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int32_t, value),
+  SoA_column(const char *, name),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+
+int main(void) {
+  std::cout << std::boolalpha;
+
+  check(soa_simd_width);
+  check(soa_batch<double>::size);
+  check(soa_batch<int32_t>::size);
+  check(soa_batch<uint16_t>::size);
+  check(soa_simd_width_of<int32_t>());
+  // the integer batches are only as wide as the native integer operations, e.g. 128 bits with AVX but without AVX2
+  static_assert(soa_batch<float>::size * sizeof(float) == soa_simd_width);
+  static_assert(soa_batch<int32_t>::size * sizeof(int32_t) == soa_simd_width_of<int32_t>());
+#if defined(__AVX__) and not defined(__AVX2__)
+  static_assert(soa_batch<int32_t>::size == 4);
+#endif
+  std::cout << std::endl;
+
+  // a size that is not a multiple of the batch width
+  using Layout = SoALayout<soa_simd_width>;
+  const size_t elements = 37;
+  std::byte* buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+  Layout soa(buffer, elements);
+  for (size_t i = 0; i < elements; ++i) {
+    soa[i].x() = i;
+    soa[i].y() = 2. * i;
+    soa[i].z() = -1. * i;
+    soa[i].value() = i;
+  }
+
+  // scale and translate x, y, z together
+  using batch = soa_batch<double>;
+  soa_for_each_batch<batch::size>(soa.size(), [&](size_t i, size_t n) {
+    batch x = batch::load(soa.x() + i, n);
+    batch y = batch::load(soa.y() + i, n);
+    batch z = batch::load(soa.z() + i, n);
+    (x * 2. + y).store(soa.x() + i, n);
+    (y * 2. + z).store(soa.y() + i, n);
+    (z * 2. + x).store(soa.z() + i, n);
+  });
+
+  // aligned integer batches
+  using ibatch = soa_batch<int32_t>;
+  soa_for_each_batch<ibatch::size>(soa.size(), [&](size_t i, size_t n) {
+    if (n == ibatch::size)
+      (ibatch::load_aligned(soa.value() + i) * 3).store_aligned(soa.value() + i);
+    else
+      (ibatch::load(soa.value() + i, n) * 3).store(soa.value() + i, n);
+  });
+
+  bool ok = true;
+  for (size_t i = 0; i < elements; ++i) {
+    ok = ok and soa.x()[i] == 4. * i;
+    ok = ok and soa.y()[i] == 3. * i;
+    ok = ok and soa.z()[i] == -1. * i;
+    ok = ok and soa.value()[i] == int32_t(3 * i);
+  }
+  check(soa[36].x());
+  check(soa[36].y());
+  check(soa[36].z());
+  check(soa[36].value());
+  check(ok);
+  std::free(buffer);
+
+  return not ok;
+}
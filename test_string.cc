@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "soa_v4.h"
+#include "soa_string.h"
+
+#define check(X) \
+  do { std::cout << #X " is " << (X) << std::endl; } while(false)
+
+// the same SoA as in test_v4.cc, with the names stored as string columns instead of as pointers
+declare_SoA_template(SoA,
+  // columns: one value per element
+  SoA_column(double, x),
+  SoA_column(double, y),
+  SoA_column(double, z),
+  SoA_column(uint16_t, colour),
+  SoA_column(int32_t, value),
+  SoA_string_column(name),
+  SoA_interned_column(kind),
+  SoA_flag_column(selected),
+
+  // scalars: one value for the whole structure
+  SoA_scalar(const char *, description)
+);
+
+int main(void) {
+  std::cout << std::boolalpha;
+  bool ok = true;
+
+  const char* kinds[] = { "electron", "muon", "photon", "jet" };
+
+  soa_string_buffer names;
+  soa_dictionary dictionary;
+  SoAVector<64> soa;
+  for (size_t i = 0; i < 1000; ++i) {
+    auto element = soa.emplace_back(0.5 * i, 1., 2., uint16_t(i % 7), int32_t(i));
+    element.name() = names.add("element " + std::to_string(i));
+    element.kind() = dictionary.intern(kinds[i % 5 % 4]);
+  }
+
+  // each distinct string is stored once
+  check(dictionary.size());
+  check(dictionary[soa[7].kind()]);
+  check(names[soa[123].name()]);
+  ok = ok and dictionary.size() == 4 and dictionary[soa[7].kind()] == "photon" and names[soa[123].name()] == "element 123" and
+       dictionary.intern("muon") == soa[1].kind() and dictionary.find("tau") == soa_dictionary::npos;
+
+  // the dictionary keeps working as its hash table grows
+  for (size_t i = 0; i < 100; ++i)
+    dictionary.intern("kind " + std::to_string(i));
+  bool grow_ok = dictionary.size() == 104 and dictionary.find("kind 42").id == 46 and dictionary.find("jet") == soa[3].kind();
+  check(grow_ok);
+  ok = ok and grow_ok;
+
+  // equality filters
+  soa_string_match(soa.selected(), soa.kind(), soa.size(), dictionary, "muon");
+  size_t muons = soa_mask_count(soa.selected(), soa.size());
+  soa_string_match(soa.selected(), soa.kind(), soa.size(), dictionary, "tau");
+  size_t taus = soa_mask_count(soa.selected(), soa.size());
+  soa_string_match(soa.selected(), soa.name(), soa.size(), names, "element 999");
+  size_t named = soa_mask_count(soa.selected(), soa.size());
+  check(muons);
+  check(taus);
+  check(named);
+  ok = ok and muons == 200 and taus == 0 and named == 1 and soa[999].selected();
+
+  return not ok;
+}
@@ -1,7 +1,25 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 #include "soa_v4.h"
 
+// array of structures element, as in test_v0.cc
+struct element {
+  double x;
+  double y;
+  double z;
+  uint16_t colour;
+  int32_t value;
+  const char* name;
+};
+
 #define check(X) \
   do { std::cout << #X " is " << (X) << std::endl; } while(false)
 
@@ -26,6 +44,17 @@ declare_SoA_template(SoA,
 
 using LargeSoA = SoA<1024>;
 
+// a SoA with narrow and wide fields interleaved, that wastes space on padding in declaration order
+namespace interleaved {
+declare_SoA_template(Mixed,
+  SoA_column(uint8_t, flag),
+  SoA_column(double, x),
+  SoA_column(uint16_t, colour),
+  SoA_column(double, y),
+  SoA_scalar(uint8_t, version)
+);
+}
+
 
 int main(void) {
   std::cout << std::boolalpha;
@@ -56,6 +85,260 @@ int main(void) {
   soa[7].name() = "element";
 
   soa[9] = soa[7];
+  bool ok = (& soa.z()[7] == & (soa[7].z()));
+
+  // compile-time sized SoA, with the fields sorted by alignment
+  using SortedMixed = interleaved::Mixed<3, 0, soa_alignment_order>;
+  interleaved::dump<interleaved::Mixed<3>>();
+  interleaved::dump<SortedMixed>();
+  SortedMixed mixed;
+  mixed[2] = interleaved::MixedEntry{ 1, 2., 3, 4. };
+  mixed.version() = 5;
+  bool mixed_ok = sizeof(SortedMixed) < sizeof(interleaved::Mixed<3>) and mixed[2].flag() == 1 and mixed[2].x() == 2. and
+                  mixed[2].colour() == 3 and mixed.view()[2].y() == 4. and mixed.version() == 5 and
+                  reinterpret_cast<std::byte const*>(mixed.flag()) > reinterpret_cast<std::byte const*>(mixed.y());
+  check(mixed_ok);
+  ok = ok and mixed_ok;
+  std::cout << std::endl;
+
+  // non-owning views
+  SoAView view = soa.view();
+  check(std::is_trivially_copyable_v<SoAView>);
+  check(view.size());
+  check(& view.z()[7] == & (soa[7].z()));
+  SoAView part = view.subspan(5, 4);
+  check(part.size());
+  check(& part.z()[2] == & (soa[7].z()));
+  check(& part.description() == & soa.description());
+  part[3] = part[2];
+  ok = ok and (soa[8].y() == 3.1416);
+  SoAConstView cview = part;
+  check(cview[3].name());
+  ok = ok and (& cview.z()[2] == & (soa[7].z()));
+  // the elements of a view hold a copy of it, and stay valid after a temporary view is destroyed
+  SoAView::element held = soa.view().subspan(2, 6)[2];
+  held.value() = 4444;
+  SoAConstView::const_element cheld = SoAConstView(soa.view())[4];
+  check(cheld.value());
+  ok = ok and (soa[4].value() == 4444) and (cheld.value() == 4444);
+  std::cout << std::endl;
+
+  // iterators and standard algorithms
+  static_assert(std::is_same_v<std::iterator_traits<SoA<10, 32>::iterator>::reference, SoA<10, 32>::element>);
+  static_assert(std::is_same_v<std::iterator_traits<SoAView::const_iterator>::value_type, SoAEntry>);
+  check(std::distance(soa.begin(), soa.end()));
+  soa[0] = SoAEntry{ 1., 2., 3., 16, 1, "hello world" };
+  std::for_each(soa.begin() + 1, soa.begin() + 7, [](SoA<10, 32>::element e) {
+    e = SoAEntry{ 0., 0., 0., 0, 0, "empty" };
+  });
+  double sum = std::transform_reduce(view.cbegin(), view.cend(), 0., std::plus<>(), [](auto const& e) { return e.y(); });
+  check(sum);
+  ok = ok and (std::abs(sum - (2. + 3.1416 * 3)) < 1e-9);
+  int named = 0;
+  for (auto e: cview)
+    named += (e.name() != nullptr);
+  check(named);
+  SoAEntry entry = soa[7];
+  check(entry.value);
+
+  // standard algorithms over the iterators of temporary views, including the mutating ones
+  auto blank = std::count_if(soa.view().begin(), soa.view().end(), [](auto const& e) { return e.name() == std::string("empty"); });
+  check(blank);
+  // the comparison is also called with value_type, i.e. SoAEntry, to which the elements can be converted
+  std::sort(soa.view().begin(), soa.view().end(), [](SoAEntry const& a, SoAEntry const& b) { return a.value > b.value; });
+  check(soa[3].name());
+  std::rotate(soa.view().begin(), soa.view().begin() + 3, soa.view().end());
+  std::iter_swap(soa.view().begin(), soa.view().begin() + 7);
+  check(soa[0].value());
+  check(soa[7].name());
+  bool descending = std::is_sorted(soa.view().cbegin(), soa.view().cend(),
+                                   [](auto const& a, auto const& b) { return a.value() > b.value(); });
+  check(descending);
+  ok = ok and blank == 6 and soa[0].value() == 9999 and soa[7].value() == 1 and soa[7].name() == std::string("hello world") and
+       soa[9].y() == 3.1416 and not descending;
+  std::cout << std::endl;
+
+  // runtime-sized SoA, inside a caller-provided buffer
+  using Layout = SoALayout<32>;
+  size_t elements = 10;
+  check(Layout::buffer_alignment);
+  check(Layout::compute_data_size(elements));
+  std::byte* buffer = static_cast<std::byte*>(std::aligned_alloc(Layout::buffer_alignment, Layout::compute_data_size(elements)));
+  Layout layout(buffer, elements);
+  check(layout.size());
+  check(& layout.z()[7] == & (layout[7].z()));
+  check(reinterpret_cast<uintptr_t>(layout.colour()) % 32 == 0);
+  check(reinterpret_cast<std::byte*>(& layout.description() + 1) <= buffer + Layout::compute_data_size(elements));
+  std::cout << std::endl;
+
+  layout[7].x() = 0.;
+  layout[7].y() = 3.1416;
+  layout[7].z() = -1.;
+  layout[7].colour() = 42;
+  layout[7].value() = 9999;
+  layout[7].name() = "element";
+  layout.description() = "runtime-sized SoA";
+
+  layout[9] = layout[7];
+  ok = ok and (& layout.z()[7] == & (layout[7].z())) and (layout.y()[9] == 3.1416);
+  std::free(buffer);
+
+  // runtime-sized SoA, with the fields sorted by alignment
+  dump<SoALayout<0>>(5);
+  dump<SoALayout<0, soa_alignment_order>>(5);
+  using SortedLayout = SoALayout<0, soa_alignment_order>;
+  buffer = static_cast<std::byte*>(std::aligned_alloc(SortedLayout::buffer_alignment, SortedLayout::compute_data_size(elements)));
+  SortedLayout sorted(buffer, elements);
+  sorted[7].colour() = 42;
+  sorted.description() = "sorted SoA";
+  check(reinterpret_cast<std::byte*>(sorted.colour()) > reinterpret_cast<std::byte*>(sorted.name()));
+  ok = ok and (SortedLayout::compute_data_size(elements) <= Layout::compute_data_size(elements)) and (sorted[7].colour() == 42);
+  std::free(buffer);
+
+  // tiled SoA, with 8 elements per tile
+  using Tiled = SoATiled<8, 64>;
+  elements = 20;
+  check(sizeof(Tiled::tile_type));
+  check(Tiled::compute_data_size(elements));
+  buffer = static_cast<std::byte*>(std::aligned_alloc(Tiled::buffer_alignment, Tiled::compute_data_size(elements)));
+  Tiled tiled(buffer, elements);
+  check(tiled.tiles());
+  check(& tiled.z()[9] == & tiled.tile(1).z[1]);
+  check(reinterpret_cast<uintptr_t>(tiled.tile(2).colour) % 64 == 0);
+  for (size_t i = 0; i < tiled.size(); ++i) {
+    tiled.x()[i] = i;
+    tiled.y()[i] = 2. * i;
+    tiled.z()[i] = 3. * i;
+  }
+  tiled[7].colour() = 42;
+  tiled[7].name() = "element";
+  tiled.description() = "tiled SoA";
+  tiled[19] = tiled[7];
+  check(tiled[19].z());
+  check(tiled[19].name());
+  ok = ok and (& tiled.z()[9] == & tiled.tile(1).z[1]) and (tiled[19].z() == 21.) and (tiled.colour()[19] == 42);
+  std::free(buffer);
+  std::cout << std::endl;
+
+  // conversion from and to an array of structures
+  {
+    std::vector<element> input(150);
+    for (size_t i = 0; i < input.size(); ++i)
+      input[i] = element{ double(i), 2. * i, 3. * i, uint16_t(i % 7), int32_t(i * i), "element" };
+    SoA<200, 64> soa;
+    soa.from_aos(input.data(), input.size());
+    check(soa[149].z());
+    check(soa[149].value());
+
+    std::vector<SoAEntry> output(150);
+    soa.view().subspan(100, 50).to_aos(output.data(), 50);
+    check(output[49].x);
+    check(output[49].name);
+    bool converted = true;
+    for (size_t i = 0; i < input.size(); ++i)
+      converted = converted and soa[i].y() == input[i].y and soa[i].colour() == input[i].colour;
+    for (size_t i = 0; i < 50; ++i)
+      converted = converted and output[i].value == input[100 + i].value;
+    check(converted);
+    ok = ok and converted and output[49].x == 149.;
+  }
+  std::cout << std::endl;
+
+  // growable SoA
+  {
+    SoAVector<64> soa;
+    soa.description() = "growable SoA";
+    check(soa.size());
+    check(soa.capacity());
+    for (size_t i = 0; i < 1000; ++i)
+      soa.emplace_back(double(i), 2. * i, 3. * i, uint16_t(i % 7), int32_t(i), "element");
+    soa.push_back(SoAEntry{ -1., -2., -3., 0, -1, "last" });
+    check(soa.size());
+    check(soa.capacity());
+    check(soa[999].z());
+    check(soa[1000].name());
+    check(soa.description());
+    check(reinterpret_cast<uintptr_t>(soa.colour()) % 64 == 0);
+    bool grown = soa.size() == 1001 and soa[999].z() == 2997. and soa[500].value() == 500 and soa.description() == std::string("growable SoA");
+
+    // all the columns live in the single buffer
+    check(reinterpret_cast<std::byte*>(soa.x()) == soa.buffer());
+    check(reinterpret_cast<std::byte*>(soa.name()) < soa.buffer() + SoAVector<64>::compute_data_size(soa.capacity()));
+
+    soa.resize(1200);
+    check(soa[1100].x());
+    soa.resize(10);
+    soa.shrink_to_fit();
+    check(soa.capacity());
+    SoAVector<64> copy = soa;
+    soa.clear();
+    check(copy.size());
+    check(copy[9].y());
+    check(copy.description());
+    grown = grown and soa.empty() and copy.size() == 10 and copy[9].y() == 18. and copy.capacity() == 10;
+
+    // moving does not allocate, so a std::vector of SoAs moves them when it grows
+    static_assert(std::is_nothrow_move_constructible_v<SoAVector<64>>);
+    std::vector<SoAVector<64>> vectors;
+    vectors.push_back(std::move(copy));
+    std::byte* moved = vectors[0].buffer();
+    vectors.resize(10);
+    check(vectors[0][9].y());
+    // the moved-from SoA is empty, and allocates a new buffer when it grows again
+    copy.push_back(SoAEntry{ 1., 2., 3., 4, 5, "again" });
+    copy.description() = "moved from";
+    grown = grown and vectors[0].buffer() == moved and vectors[0][9].y() == 18. and copy.size() == 1 and copy[0].value() == 5;
+    check(grown);
+    ok = ok and grown;
+  }
+  std::cout << std::endl;
+
+  // projections over a subset of the fields
+  {
+    SoAVector<64> soa;
+    for (size_t i = 0; i < 100; ++i)
+      soa.emplace_back(double(i), 2. * i, 3. * i, uint16_t(i % 7), int32_t(i), "element");
+    soa.description() = "projection";
+
+    auto position = soa.select<SoAField::x, SoAField::y, SoAField::z, SoAField::description>();
+    check(sizeof(position));
+    check(position[7].z());
+    check(position.description());
+
+    // copying an element of the projection copies only the selected columns
+    position[9] = position[7];
+    check(soa[9].x());
+    check(soa[9].value());
+    bool projected = soa[9].x() == 7. and soa[9].z() == 21. and soa[9].value() == 9 and soa[9].colour() == 2 and
+                     std::tuple_size_v<decltype(position.columns())> == 3 and position.x() == soa.x() and
+                     position.subspan(10, 5)[0].y() == 20. and position.description() == std::string("projection");
+
+    // a read-only projection, listing the fields in a different order
+    SoAConstView view = soa.view();
+    auto values = view.select<SoAField::value, SoAField::x>();
+    check(values[42].value());
+    projected = projected and values[42].value() == 42 and values[42].x() == 42. and std::get<0>(values.columns()) == soa.value();
+
+    // the elements of a temporary projection stay valid
+    auto far = soa.view().select<SoAField::x>()[50];
+    far.x() = -50.;
+    projected = projected and soa[50].x() == -50.;
+
+    // the owning SoAs forward to their views; a const SoA gives a read-only projection
+    SoAVector<64> const& constant = soa;
+    auto constant_values = constant.select<SoAField::value>();
+    static_assert(std::is_same_v<decltype(constant_values), SoAProjection<SoAConstView, SoAField::value>>);
+    static LargeSoA fixed;
+    auto fixed_position = fixed.select<SoAField::x, SoAField::y, SoAField::z>();
+    fixed_position[3].z() = position[3].z();
+    fixed_position[3].y() = position[3].y();
+    LargeSoA const& fixed_constant = fixed;
+    projected = projected and constant_values[60].value() == 60 and fixed[3].z() == 9. and fixed[3].value() == 0 and
+                fixed_constant.select<SoAField::y>()[3].y() == 6.;
+    check(projected);
+    ok = ok and projected;
+  }
+  std::cout << std::endl;
 
-  return not (& soa.z()[7] == & (soa[7].z()));
+  return not ok;
 }